@@ -0,0 +1,578 @@
+/**
+ * @file compressed_time_series.hpp
+ * license License BSD-3-Clause
+ * @copyright Copyright (c) 2019, Max Planck Gesellschaft.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "signal_handler/exceptions.hpp"
+#include "signal_handler/signal_handler.hpp"
+
+#include "real_time_tools/timer.hpp"
+
+#include "time_series/interface.hpp"
+#include "time_series/internal/aligned_allocator.hpp"
+#include "time_series/internal/compression.hpp"
+
+namespace time_series
+{
+namespace internal
+{
+// access to the scalars of the elements of compressed time series:
+// arithmetic types, and fixed size Eigen matrices (or any type providing
+// Scalar, SizeAtCompileTime and data()) of arithmetic scalars.
+
+template <typename T, typename = void>
+struct Scalars
+{
+    static constexpr bool supported = false;
+};
+
+template <typename T>
+struct Scalars<T, std::enable_if_t<std::is_arithmetic<T>::value>>
+{
+    static constexpr bool supported = true;
+    typedef T Scalar;
+    static constexpr std::size_t size = 1;
+    static Scalar *data(T &t)
+    {
+        return &t;
+    }
+    static const Scalar *data(const T &t)
+    {
+        return &t;
+    }
+};
+
+template <typename T>
+struct Scalars<
+    T,
+    std::enable_if_t<std::is_arithmetic<typename T::Scalar>::value &&
+                     (T::SizeAtCompileTime > 0)>>
+{
+    static constexpr bool supported = true;
+    typedef typename T::Scalar Scalar;
+    static constexpr std::size_t size =
+        static_cast<std::size_t>(T::SizeAtCompileTime);
+    static Scalar *data(T &t)
+    {
+        return t.data();
+    }
+    static const Scalar *data(const T &t)
+    {
+        return t.data();
+    }
+};
+
+}  // namespace internal
+
+/**
+ * @brief Threadsafe time series keeping a long history of numeric
+ * elements in compressed form.
+ *
+ * Elements are arithmetic values or fixed size Eigen matrices (of
+ * arithmetic scalars). The elements are stored in blocks of block_length
+ * elements. The newest block is kept uncompressed (fast access to the
+ * recent elements) while being encoded incrementally. Once full, it is
+ * sealed: only its encoding is kept, using the scheme of Facebook's Gorilla
+ * (delta-of-delta timestamps, xor encoded values, see
+ * internal/compression.hpp). Regular timestamps and slowly varying values
+ * are encoded in a few bits.
+ *
+ * Accessing an element of a sealed block decodes the block (the last decoded
+ * block is cached), and visit_range decodes only the blocks of the range.
+ * The compression is lossless for the elements; timestamps are stored with
+ * a nanosecond resolution.
+ *
+ * The oldest elements are dropped by whole blocks, so that the time series
+ * contains between max_length - block_length + 1 and max_length elements
+ * once full.
+ */
+template <typename T = double>
+class CompressedTimeSeries : public TimeSeriesInterface<T>
+{
+    typedef internal::Scalars<T> Scalars;
+    static_assert(Scalars::supported,
+                  "CompressedTimeSeries supports arithmetic types and fixed "
+                  "size Eigen matrices");
+
+public:
+    /**
+     * @param max_length max number of elements in the time series
+     * @param block_length number of elements per compressed block
+     * @param start_timeindex time index of the first element
+     * @param throw_on_sigint if true, a signal_handler::ReceivedSignal
+     *     exception is thrown when a SIGINT signal is received while waiting
+     * @throws std::invalid_argument if block_length is 0 or larger than
+     * max_length
+     */
+    CompressedTimeSeries(size_t max_length,
+                         size_t block_length = 1024,
+                         Index start_timeindex = 0,
+                         bool throw_on_sigint = true)
+        : max_length_(max_length),
+          block_length_(block_length),
+          start_timeindex_(start_timeindex),
+          throw_on_sigint_(throw_on_sigint),
+          oldest_timeindex_(start_timeindex),
+          newest_timeindex_(start_timeindex - 1),
+          tagged_timeindex_(start_timeindex - 1),
+          waiters_(0),
+          hot_first_(start_timeindex),
+          writer_(hot_bits_),
+          value_encoders_(Scalars::size),
+          decoded_first_(start_timeindex - 1)
+    {
+        if (block_length == 0 || block_length > max_length)
+        {
+            throw std::invalid_argument(
+                "CompressedTimeSeries: invalid block length " +
+                std::to_string(block_length) + " (max length " +
+                std::to_string(max_length) + ")");
+        }
+        if (throw_on_sigint)
+        {
+            signal_handler::SignalHandler::initialize();
+        }
+        hot_elements_.reserve(block_length);
+        hot_timestamps_.reserve(block_length);
+    }
+
+    Index newest_timeindex(bool wait = true) const
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (newest_timeindex_ < start_timeindex_)
+        {
+            if (!wait)
+            {
+                return EMPTY;
+            }
+            wait_for(lock, start_timeindex_, NO_TIMEOUT);
+        }
+        return newest_timeindex_;
+    }
+
+    Index count_appended_elements() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return newest_timeindex_ - start_timeindex_ + 1;
+    }
+
+    Index oldest_timeindex(bool wait = true) const
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (newest_timeindex_ < start_timeindex_)
+        {
+            if (!wait)
+            {
+                return EMPTY;
+            }
+            wait_for(lock, start_timeindex_, NO_TIMEOUT);
+        }
+        return oldest_timeindex_;
+    }
+
+    T newest_element() const
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wait_for(lock, start_timeindex_, NO_TIMEOUT);
+        return hot_elements_.back();
+    }
+
+    T operator[](const Index &timeindex) const
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wait_for(lock, timeindex, NO_TIMEOUT);
+        // (after waiting: appends may have dropped the element meanwhile)
+        throw_if_too_old(timeindex);
+        if (timeindex >= hot_first_)
+        {
+            return hot_elements_[timeindex - hot_first_];
+        }
+        decode(timeindex);
+        return decoded_elements_[timeindex - decoded_first_];
+    }
+
+    Timestamp timestamp_ms(const Index &timeindex) const
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wait_for(lock, timeindex, NO_TIMEOUT);
+        // (after waiting: appends may have dropped the element meanwhile)
+        throw_if_too_old(timeindex);
+        if (timeindex >= hot_first_)
+        {
+            return hot_timestamps_[timeindex - hot_first_];
+        }
+        decode(timeindex);
+        return decoded_timestamps_[timeindex - decoded_first_];
+    }
+
+    Timestamp timestamp_s(const Index &timeindex) const
+    {
+        return timestamp_ms(timeindex) / 1000.;
+    }
+
+    bool wait_for_timeindex(const Index &timeindex,
+                            const double &max_duration_s =
+                                std::numeric_limits<double>::quiet_NaN()) const
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        throw_if_too_old(timeindex);
+        return wait_for(lock, timeindex, max_duration_s);
+    }
+
+    size_t length() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return newest_timeindex_ - oldest_timeindex_ + 1;
+    }
+
+    size_t max_length() const
+    {
+        return max_length_;
+    }
+
+    bool has_changed_since_tag() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return tagged_timeindex_ != newest_timeindex_;
+    }
+
+    void tag(const Index &timeindex)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tagged_timeindex_ = timeindex;
+    }
+
+    Index tagged_timeindex() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return tagged_timeindex_;
+    }
+
+    void append(const T &element)
+    {
+        // nanosecond resolution, so that the timestamp read from
+        // the hot block is the same as once the block is sealed
+        std::int64_t timestamp_ns = std::llround(
+            real_time_tools::Timer::get_current_time_ms() * 1e6);
+        bool has_waiters;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (hot_elements_.size() == block_length_)
+            {
+                seal();
+            }
+            hot_elements_.push_back(element);
+            hot_timestamps_.push_back(to_ms(timestamp_ns));
+            timestamps_encoder_.encode(timestamp_ns, writer_);
+            const typename Scalars::Scalar *scalars = Scalars::data(element);
+            for (std::size_t i = 0; i < Scalars::size; i++)
+            {
+                value_encoders_[i].encode(to_bits(scalars[i]), writer_);
+            }
+            newest_timeindex_++;
+            // dropping the oldest block
+            if (newest_timeindex_ - oldest_timeindex_ + 1 >
+                static_cast<Index>(max_length_))
+            {
+                sealed_.pop_front();
+                oldest_timeindex_ += block_length_;
+            }
+            has_waiters = waiters_ > 0;
+        }
+        if (has_waiters)
+        {
+            condition_.notify_all();
+        }
+    }
+
+    bool is_empty() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return newest_timeindex_ < start_timeindex_;
+    }
+
+    /**
+     * @brief returns the newest element, with its index and timestamp,
+     * read in a single critical section. Waits if the time series is empty.
+     */
+    Sample<T> newest() const
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wait_for(lock, start_timeindex_, NO_TIMEOUT);
+        return Sample<T>{
+            newest_timeindex_, hot_elements_.back(), hot_timestamps_.back()};
+    }
+
+    /**
+     * @brief returns the element of the given index, with its timestamp,
+     * read in a single critical section. Waits if the element is not yet
+     * in the time series.
+     * @throws std::invalid_argument if the element is too old.
+     */
+    Sample<T> at(const Index &timeindex) const
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wait_for(lock, timeindex, NO_TIMEOUT);
+        // (after waiting: appends may have dropped the element meanwhile)
+        throw_if_too_old(timeindex);
+        if (timeindex >= hot_first_)
+        {
+            return Sample<T>{timeindex,
+                             hot_elements_[timeindex - hot_first_],
+                             hot_timestamps_[timeindex - hot_first_]};
+        }
+        decode(timeindex);
+        return Sample<T>{timeindex,
+                         decoded_elements_[timeindex - decoded_first_],
+                         decoded_timestamps_[timeindex - decoded_first_]};
+    }
+
+    /**
+     * @brief Calls f(const T* elements, const Timestamp* timestamps,
+     * std::size_t nb_elements) on successive chunks of the elements (and
+     * their timestamps) from first to last (included), in order: one chunk
+     * per block touched by the range. Only these blocks are decoded.
+     * Waits if last is not yet in the time series.
+     * f is called while the time series is locked: it should not call any
+     * method of this time series, and the pointers should not be used after
+     * f returns.
+     * @throws std::invalid_argument if first is older than the oldest
+     * element, or if last is smaller than first.
+     */
+    template <typename F>
+    void visit_range(const Index &first, const Index &last, F f) const
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (last < first)
+        {
+            throw std::invalid_argument("visit_range: invalid range " +
+                                        std::to_string(first) + " to " +
+                                        std::to_string(last));
+        }
+        wait_for(lock, last, NO_TIMEOUT);
+        // (after waiting: appends may have dropped the elements meanwhile)
+        throw_if_too_old(first);
+        Index index = first;
+        while (index < std::min(last + 1, hot_first_))
+        {
+            decode(index);
+            Index end = std::min(last + 1,
+                                 decoded_first_ + static_cast<Index>(
+                                                      decoded_elements_.size()));
+            f(decoded_elements_.data() + (index - decoded_first_),
+              decoded_timestamps_.data() + (index - decoded_first_),
+              static_cast<std::size_t>(end - index));
+            index = end;
+        }
+        if (index <= last)
+        {
+            f(hot_elements_.data() + (index - hot_first_),
+              hot_timestamps_.data() + (index - hot_first_),
+              static_cast<std::size_t>(last - index + 1));
+        }
+    }
+
+    //! @brief number of elements per block
+    size_t block_length() const
+    {
+        return block_length_;
+    }
+
+    /**
+     * @brief returns the number of bytes used for storing the elements
+     * and timestamps (sealed blocks and hot block).
+     */
+    std::size_t memory_usage() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::size_t bytes = hot_bits_.capacity() * sizeof(std::uint64_t) +
+                            hot_elements_.capacity() * sizeof(T) +
+                            hot_timestamps_.capacity() * sizeof(Timestamp);
+        for (const Block &block : sealed_)
+        {
+            bytes += block.bits.capacity() * sizeof(std::uint64_t);
+        }
+        return bytes;
+    }
+
+private:
+    static constexpr double NO_TIMEOUT = std::numeric_limits<double>::quiet_NaN();
+
+    struct Block
+    {
+        Index first;
+        internal::Bits bits;
+    };
+
+    typedef typename Scalars::Scalar Scalar;
+    static_assert(sizeof(Scalar) <= sizeof(std::uint64_t),
+                  "CompressedTimeSeries: scalars of more than 64 bits are "
+                  "not supported");
+
+    static std::uint64_t to_bits(Scalar scalar)
+    {
+        std::uint64_t bits = 0;
+        std::memcpy(&bits, &scalar, sizeof(Scalar));
+        return bits;
+    }
+
+    static Scalar from_bits(std::uint64_t bits)
+    {
+        Scalar scalar;
+        std::memcpy(&scalar, &bits, sizeof(Scalar));
+        return scalar;
+    }
+
+    static Timestamp to_ms(std::int64_t timestamp_ns)
+    {
+        return static_cast<Timestamp>(timestamp_ns) / 1e6L;
+    }
+
+    // moves the encoding of the (full) hot block to the sealed blocks.
+    // To be called with the lock held.
+    void seal()
+    {
+        Block block{hot_first_, std::move(hot_bits_)};
+        block.bits.shrink_to_fit();
+        sealed_.push_back(std::move(block));
+        writer_.clear();
+        timestamps_encoder_.reset();
+        for (internal::XorEncoder &encoder : value_encoders_)
+        {
+            encoder.reset();
+        }
+        hot_first_ += block_length_;
+        hot_elements_.clear();
+        hot_timestamps_.clear();
+    }
+
+    // decodes the sealed block containing timeindex in decoded_elements_
+    // and decoded_timestamps_ (unless already done).
+    // To be called with the lock held.
+    void decode(Index timeindex) const
+    {
+        Index block_index =
+            (timeindex - sealed_.front().first) / static_cast<Index>(block_length_);
+        const Block &block = sealed_[block_index];
+        if (decoded_first_ == block.first && !decoded_elements_.empty())
+        {
+            return;
+        }
+        decoded_elements_.resize(block_length_);
+        decoded_timestamps_.resize(block_length_);
+        internal::BitReader reader(block.bits);
+        internal::DeltaOfDeltaDecoder timestamps_decoder;
+        std::vector<internal::XorDecoder> value_decoders(Scalars::size);
+        for (std::size_t i = 0; i < block_length_; i++)
+        {
+            decoded_timestamps_[i] = to_ms(timestamps_decoder.decode(reader));
+            Scalar *scalars = Scalars::data(decoded_elements_[i]);
+            for (std::size_t j = 0; j < Scalars::size; j++)
+            {
+                scalars[j] = from_bits(value_decoders[j].decode(reader));
+            }
+        }
+        decoded_first_ = block.first;
+    }
+
+    void throw_if_too_old(const Index &timeindex) const
+    {
+        if (timeindex < oldest_timeindex_)
+        {
+            throw std::invalid_argument(
+                "you tried to access time_series element " +
+                std::to_string(timeindex) +
+                " which is too old (oldest in buffer is " +
+                std::to_string(oldest_timeindex_) + ").");
+        }
+    }
+
+    // waits until newest_timeindex_ >= timeindex. Returns false on timeout
+    // (or if SIGINT is received and max_duration_s is not NaN).
+    bool wait_for(std::unique_lock<std::mutex> &lock,
+                  Index timeindex,
+                  double max_duration_s) const
+    {
+        // duration of each wait, so that SIGINT is checked regularly
+        constexpr double SLICE_S = 0.1;
+
+        bool timed = std::isfinite(max_duration_s);
+        std::chrono::steady_clock::time_point deadline =
+            std::chrono::steady_clock::now() +
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(timed ? max_duration_s : 0));
+        while (newest_timeindex_ < timeindex)
+        {
+            bool sigint = signal_handler::SignalHandler::has_received_sigint();
+            if (timed)
+            {
+                if (sigint || std::chrono::steady_clock::now() >= deadline)
+                {
+                    return false;
+                }
+            }
+            else if (sigint && throw_on_sigint_)
+            {
+                throw signal_handler::ReceivedSignal(SIGINT);
+            }
+            std::chrono::steady_clock::time_point slice_end =
+                std::chrono::steady_clock::now() +
+                std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double>(SLICE_S));
+            waiters_++;
+            condition_.wait_until(
+                lock, timed ? std::min(slice_end, deadline) : slice_end);
+            waiters_--;
+        }
+        return true;
+    }
+
+    const size_t max_length_;
+    const size_t block_length_;
+    const Index start_timeindex_;
+    const bool throw_on_sigint_;
+
+    // all members below are guarded by mutex_
+    mutable std::mutex mutex_;
+    mutable std::condition_variable condition_;
+
+    Index oldest_timeindex_;
+    Index newest_timeindex_;
+    Index tagged_timeindex_;
+    mutable long waiters_;
+
+    std::deque<Block> sealed_;
+
+    // hot block: uncompressed elements, and their encoding so far
+    Index hot_first_;
+    std::vector<T, internal::AlignedAllocator<T>> hot_elements_;
+    std::vector<Timestamp> hot_timestamps_;
+    internal::Bits hot_bits_;
+    internal::BitWriter writer_;
+    internal::DeltaOfDeltaEncoder timestamps_encoder_;
+    std::vector<internal::XorEncoder> value_encoders_;
+
+    // last decoded sealed block
+    mutable Index decoded_first_;
+    mutable std::vector<T, internal::AlignedAllocator<T>> decoded_elements_;
+    mutable std::vector<Timestamp> decoded_timestamps_;
+};
+
+}  // namespace time_series
@@ -0,0 +1,178 @@
+/**
+ * @file coroutines.hpp
+ * license License BSD-3-Clause
+ * @copyright Copyright (c) 2019, Max Planck Gesellschaft.
+ */
+
+#pragma once
+
+/**
+ * C++20 coroutine awaitables for waiting on new elements without blocking
+ * a thread:
+ *
+ *   Sample<T> sample = co_await async_at(ts, index, executor);
+ *   Sample<T> sample = co_await async_next(ts, sample.index, executor);
+ *
+ * The coroutine is suspended until the element gets appended, then resumed
+ * via the executor, i.e. a callable taking a std::function<void()> (e.g.
+ * posting it to a thread pool, see WorkerPool::executor, or an event loop).
+ * There is no default executor: with InlineExecutor (explicit opt-in), the
+ * coroutine runs in the thread calling append (or the reactor thread),
+ * i.e. in the (maybe real time) append path of the writer.
+ * For TimeSeries, append resumes the coroutine (see
+ * TimeSeries::when_available). For other time series (e.g.
+ * MultiprocessTimeSeries followers), a Reactor polls for the element.
+ *
+ * The library itself is built as C++17: the content of this header is
+ * available only to code compiled with coroutine support (C++20).
+ */
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#include <coroutine>
+#include <functional>
+#include <utility>
+
+#include "time_series/interface.hpp"
+#include "time_series/reactor.hpp"
+#include "time_series/time_series.hpp"
+
+namespace time_series
+{
+/**
+ * @brief resumes the coroutine in the thread in which the element is
+ * detected: the thread calling append (which then runs the coroutine
+ * until its next suspension before returning), or the reactor thread.
+ * To be used only for coroutines which do not delay the writer.
+ */
+struct InlineExecutor
+{
+    void operator()(std::function<void()> f) const
+    {
+        f();
+    }
+};
+
+namespace internal
+{
+// TS: the time series (with at(Index) returning a Sample)
+// Register: bool(Index, std::function<void()>), returning false if the
+// element is already available (e.g. TimeSeries::when_available)
+template <typename TS, typename Register, typename Executor>
+class SampleAwaitable
+{
+public:
+    SampleAwaitable(TS& time_series,
+                    Index timeindex,
+                    Register register_callback,
+                    Executor executor)
+        : time_series_(time_series),
+          timeindex_(timeindex),
+          register_(std::move(register_callback)),
+          executor_(std::move(executor))
+    {
+    }
+
+    bool await_ready() const
+    {
+        return time_series_.newest_timeindex(false) >= timeindex_;
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        Executor executor = executor_;
+        // the callback may resume (and destroy) the coroutine before
+        // register_ returns: this awaitable should not be used afterwards
+        return register_(timeindex_, [handle, executor]() mutable {
+            executor([handle]() { handle.resume(); });
+        });
+    }
+
+    auto await_resume() const
+    {
+        return time_series_.at(timeindex_);
+    }
+
+private:
+    TS& time_series_;
+    Index timeindex_;
+    Register register_;
+    Executor executor_;
+};
+
+template <typename TS, typename Register, typename Executor>
+SampleAwaitable<TS, Register, Executor> make_sample_awaitable(
+    TS& time_series, Index timeindex, Register r, Executor executor)
+{
+    return SampleAwaitable<TS, Register, Executor>(
+        time_series, timeindex, std::move(r), std::move(executor));
+}
+
+}  // namespace internal
+
+/**
+ * @brief awaitable returning (as at(timeindex)) the sample of index
+ * timeindex, suspending the coroutine until it has been appended.
+ * The sample is read when the coroutine is resumed, so
+ * std::invalid_argument is thrown if the element got dropped meanwhile.
+ */
+template <typename T, typename Policies, typename Executor>
+auto async_at(TimeSeries<T, Policies>& time_series,
+              Index timeindex,
+              Executor executor)
+{
+    TimeSeries<T, Policies>* ts = &time_series;
+    return internal::make_sample_awaitable(
+        time_series,
+        timeindex,
+        [ts](Index index, std::function<void()> callback) {
+            return ts->when_available(index, std::move(callback));
+        },
+        std::move(executor));
+}
+
+//! @brief awaitable returning the sample following previous_timeindex
+template <typename T, typename Policies, typename Executor>
+auto async_next(TimeSeries<T, Policies>& time_series,
+                Index previous_timeindex,
+                Executor executor)
+{
+    return async_at(time_series, previous_timeindex + 1, std::move(executor));
+}
+
+/**
+ * @brief same as async_at, the element being detected by the reactor
+ * (for time series filled by another process). TS should provide
+ * at(Index), e.g. MultiprocessTimeSeries.
+ */
+template <typename TS, typename Executor>
+auto async_at(Reactor& reactor,
+              TS& time_series,
+              Index timeindex,
+              Executor executor)
+{
+    Reactor* r = &reactor;
+    TS* ts = &time_series;
+    return internal::make_sample_awaitable(
+        time_series,
+        timeindex,
+        [r, ts](Index index, std::function<void()> callback) {
+            return r->when_available(*ts, index, std::move(callback));
+        },
+        std::move(executor));
+}
+
+//! @brief same as async_next, the element being detected by the reactor
+template <typename TS, typename Executor>
+auto async_next(Reactor& reactor,
+                TS& time_series,
+                Index previous_timeindex,
+                Executor executor)
+{
+    return async_at(
+        reactor, time_series, previous_timeindex + 1, std::move(executor));
+}
+
+}  // namespace time_series
+
+#endif
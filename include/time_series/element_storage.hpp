@@ -0,0 +1,154 @@
+/**
+ * @file element_storage.hpp
+ * license License BSD-3-Clause
+ * @copyright Copyright (c) 2019, Max Planck Gesellschaft.
+ */
+
+#pragma once
+
+#include <string>
+#include <type_traits>
+
+#include "shared_memory/serializer.hpp"
+
+namespace time_series
+{
+/**
+ * How the elements of a multiprocess time series (SingleSegment layout)
+ * are stored in the shared memory, selected at compile time for each
+ * element type (see StorageMethodOf):
+ * - RAW: trivially copyable types, copied (memcpy) in and out of their slot.
+ * - FLAT: types declaring a fixed layout flat form (see FlatForm), stored
+ *   as this form, which can be read in place (see
+ *   MultiprocessTimeSeries::visit).
+ * - SERIALIZED: other types, serialized via shared_memory::Serializer
+ *   (i.e. cereal) on each write and read.
+ * (the MultipleSegments layout stores the elements via
+ * shared_memory::array, which serializes all non fundamental types)
+ */
+enum class StorageMethod
+{
+    RAW,
+    FLAT,
+    SERIALIZED
+};
+
+inline std::string to_string(StorageMethod storage_method)
+{
+    switch (storage_method)
+    {
+        case StorageMethod::RAW:
+            return "raw";
+        case StorageMethod::FLAT:
+            return "flat";
+        default:
+            return "serialized";
+    }
+}
+
+/**
+ * Specialize to declare the flat form of a type, e.g.:
+ *
+ * template <>
+ * struct FlatForm<Command>
+ * {
+ *     typedef CommandData type;  // trivially copyable, fixed size
+ *     static void to_flat(const Command& command, type& flat);
+ *     static void from_flat(const type& flat, Command& command);
+ * };
+ *
+ * to_flat is given the slot of the element in the shared memory: it must
+ * write all of the flat form (which otherwise keeps the data of an older
+ * element), and must not write beyond it (e.g. bounding the copy of a
+ * container by the size of the flat form).
+ */
+template <typename T>
+struct FlatForm
+{
+};
+
+namespace internal
+{
+template <typename T, typename = void>
+struct HasFlatForm : std::false_type
+{
+};
+
+template <typename T>
+struct HasFlatForm<T, std::void_t<typename FlatForm<T>::type>>
+    : std::true_type
+{
+};
+}  // namespace internal
+
+/**
+ * Storage method of the elements of type T: FLAT if FlatForm<T> is
+ * specialized, RAW if T is trivially copyable, SERIALIZED otherwise.
+ * May be specialized to force serialization, e.g. for trivially copyable
+ * types holding pointers.
+ */
+template <typename T>
+struct StorageMethodOf
+{
+    static constexpr StorageMethod value =
+        internal::HasFlatForm<T>::value
+            ? StorageMethod::FLAT
+            : (std::is_trivially_copyable<T>::value
+                   ? StorageMethod::RAW
+                   : StorageMethod::SERIALIZED);
+};
+
+//! @brief storage method of T, e.g. for static assertions
+template <typename T>
+constexpr StorageMethod storage_method_v = StorageMethodOf<T>::value;
+
+/**
+ * @brief Type stored in the slots of the shared memory for elements of type
+ * T: T (RAW), its flat form (FLAT), or the serialized bytes
+ * (SERIALIZED, std::string).
+ */
+template <typename T, StorageMethod = storage_method_v<T>>
+struct StoredType
+{
+    typedef T type;
+};
+
+template <typename T>
+struct StoredType<T, StorageMethod::FLAT>
+{
+    typedef typename FlatForm<T>::type type;
+    static_assert(std::is_trivially_copyable<type>::value &&
+                      std::is_trivially_default_constructible<type>::value,
+                  "FlatForm: the flat form should be trivially copyable "
+                  "and trivially default constructible");
+};
+
+template <typename T>
+struct StoredType<T, StorageMethod::SERIALIZED>
+{
+    typedef std::string type;
+};
+
+/**
+ * @brief describes how the elements of type T are stored, and the size
+ * of their slots, e.g. "flat (48 bytes)", for logging which path each
+ * element type takes.
+ */
+template <typename T>
+std::string storage_report()
+{
+    std::size_t size;
+    if constexpr (storage_method_v<T> == StorageMethod::SERIALIZED)
+    {
+        size = shared_memory::Serializer<T>::serializable_size();
+    }
+    else
+    {
+        size = sizeof(typename StoredType<T>::type);
+    }
+    return to_string(storage_method_v<T>) + " (" +
+           (storage_method_v<T> == StorageMethod::SERIALIZED ? "up to " : "") +
+           std::to_string(size) + " bytes)";
+}
+
+}  // namespace time_series
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <cstddef>
 #include <limits>
 
@@ -14,9 +15,23 @@ namespace time_series
 {
 typedef long int Index;
 typedef long double Timestamp;
+//! absolute deadline of a wait (see TimeSeriesBase::wait_until)
+typedef std::chrono::steady_clock::time_point Deadline;
 
 const Index EMPTY = -1;
 
+/**
+ * \brief An element of a time series, together with its time index and
+ * timestamp (in milliseconds; NaN for time series without timestamps).
+ */
+template <typename T>
+struct Sample
+{
+    Index index;
+    T element;
+    Timestamp timestamp;
+};
+
 /**
  * \brief Interface for time series.
  * A time_series implements  \f$ X_{{oldest}:{newest}} \f$ which can
@@ -0,0 +1,114 @@
+// Copyright (c) 2019 Max Planck Gesellschaft
+// Vincent Berenz
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+#include "time_series/internal/memory.hpp"
+
+namespace time_series
+{
+namespace internal
+{
+// size of a cache line on the targeted (x86_64 and aarch64) platforms.
+// Also a multiple of the widest SIMD registers alignment (AVX-512).
+constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+// Allocator returning memory aligned on (at least) a cache line, and
+// on the alignment required by T if it is larger (over aligned types).
+// Used for the storage of single process time series, so that
+// the slots of vectorizable types (e.g. fixed size Eigen matrices)
+// are aligned and the elements can be mapped for SIMD computations
+// without copy.
+// The allocator may also be requested to use huge pages, and to commit the
+// memory in a given way (see memory_options.hpp).
+template <typename T>
+class AlignedAllocator
+{
+public:
+    typedef T value_type;
+
+    static constexpr std::size_t alignment =
+        std::max(CACHE_LINE_SIZE, alignof(T));
+
+    template <typename U>
+    struct rebind
+    {
+        typedef AlignedAllocator<U> other;
+    };
+
+    AlignedAllocator(PageBacking page_backing = PageBacking::DEFAULT_PAGES,
+                     MemoryCommit commit = MemoryCommit::DEFAULT) noexcept
+        : requested_{page_backing, commit},
+          obtained_{PageBacking::DEFAULT_PAGES, MemoryCommit::DEFAULT}
+    {
+    }
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U> &other) noexcept
+        : requested_(other.requested()), obtained_(other.obtained())
+    {
+    }
+
+    T *allocate(std::size_t n)
+    {
+        return static_cast<T *>(
+            allocate_memory(n * sizeof(T), alignment, requested_, obtained_));
+    }
+
+    void deallocate(T *p, std::size_t n) noexcept
+    {
+        deallocate_memory(p, n * sizeof(T), alignment, obtained_);
+    }
+
+    template <typename U, typename... Args>
+    void construct(U *p, Args &&... args)
+    {
+        if constexpr (sizeof...(Args) == 0)
+        {
+            if (requested_.commit == MemoryCommit::LAZY)
+            {
+                // default initialization: for trivial types, the memory
+                // is not written (and so not committed)
+                ::new (static_cast<void *>(p)) U;
+                return;
+            }
+        }
+        ::new (static_cast<void *>(p)) U(std::forward<Args>(args)...);
+    }
+
+    const Allocation &requested() const
+    {
+        return requested_;
+    }
+
+    //! what was obtained by the last allocation
+    const Allocation &obtained() const
+    {
+        return obtained_;
+    }
+
+private:
+    Allocation requested_;
+    Allocation obtained_;
+};
+
+template <typename T, typename U>
+bool operator==(const AlignedAllocator<T> &a, const AlignedAllocator<U> &b)
+{
+    return a.obtained().page_backing == b.obtained().page_backing &&
+           a.obtained().commit == b.obtained().commit;
+}
+
+template <typename T, typename U>
+bool operator!=(const AlignedAllocator<T> &a, const AlignedAllocator<U> &b)
+{
+    return !(a == b);
+}
+
+}  // namespace internal
+}  // namespace time_series
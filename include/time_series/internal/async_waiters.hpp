@@ -0,0 +1,44 @@
+// Copyright (c) 2019 Max Planck Gesellschaft
+// Vincent Berenz
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <mutex>
+
+#include "time_series/interface.hpp"
+
+namespace time_series
+{
+namespace internal
+{
+// Callbacks waiting for a time index, registered by
+// TimeSeries::when_available and called by TimeSeries::append.
+// append only reads an atomic counter when nothing is registered.
+class AsyncWaiters
+{
+public:
+    AsyncWaiters();
+
+    // registers the callback, to be called by the first dispatch
+    // with newest >= timeindex
+    void add(Index timeindex, std::function<void()> callback);
+
+    // calls (outside of the internal lock) and unregisters the
+    // callbacks waiting for a time index <= newest
+    void dispatch(Index newest);
+
+    // number of registered callbacks
+    std::size_t size() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::multimap<Index, std::function<void()>> callbacks_;
+    std::atomic<std::size_t> size_;
+};
+
+}  // namespace internal
+}  // namespace time_series
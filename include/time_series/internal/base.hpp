@@ -3,15 +3,27 @@
 
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <cmath>
+#include <limits>
+#include <memory>
+#include <optional>
 #include <thread>
+#include <vector>
 
 #include "signal_handler/exceptions.hpp"
 #include "signal_handler/signal_handler.hpp"
 
 #include "time_series/interface.hpp"
+#include "time_series/interpolation.hpp"
+#include "time_series/lock_options.hpp"
+#include "time_series/memory_options.hpp"
+#include "time_series/period_statistics.hpp"
+#include "time_series/policies.hpp"
+#include "time_series/internal/indexes.hpp"
+#include "time_series/internal/period_tracker.hpp"
 #include "time_series/internal/specialized_classes.hpp"
 
 #include "real_time_tools/timer.hpp"
@@ -25,8 +37,9 @@ namespace internal
 
 // P will be expected to be SINGLEPROCESS or MULTIPROCESS
 // (types defined in specialized_classes.hpp)
+// Policies: see policies.hpp
 
-template <typename P, typename T = int>
+template <typename P, typename T = int, typename Policies = DefaultPolicies>
 class TimeSeriesBase : public TimeSeriesInterface<T>
 {
 public:
@@ -39,7 +52,7 @@ public:
      *     one of the getter methods.
      */
     TimeSeriesBase(Index start_timeindex = 0, bool throw_on_sigint = true);
-    TimeSeriesBase(TimeSeriesBase<P, T> &&other) noexcept;
+    TimeSeriesBase(TimeSeriesBase<P, T, Policies> &&other) noexcept;
     ~TimeSeriesBase();
     Index newest_timeindex(bool wait = true) const;
     Index count_appended_elements() const;
@@ -51,6 +64,41 @@ public:
     bool wait_for_timeindex(const Index &timeindex,
                             const double &max_duration_s =
                                 std::numeric_limits<double>::quiet_NaN()) const;
+
+    /**
+     * @brief waits until the element of index timeindex is appended,
+     * or until the deadline (on the monotonic clock). Unlike
+     * wait_for_timeindex, the deadline is kept across wake ups, so the
+     * wait never lasts longer than requested (up to the scheduling of
+     * the thread).
+     * @returns false if the deadline passed (or SIGINT was received)
+     * before the element was appended.
+     * @throws std::invalid_argument if the element is older than the
+     * oldest element.
+     */
+    bool wait_until(const Index &timeindex, const Deadline &deadline) const;
+
+    /**
+     * @brief as at, but waiting for the element only until the deadline
+     * (see wait_until).
+     * @returns the element with its index and timestamp, or nothing if
+     * the deadline passed (or SIGINT was received) before the element
+     * was appended.
+     * @throws std::invalid_argument if the element is older than the
+     * oldest element.
+     */
+    std::optional<Sample<T>> at_until(const Index &timeindex,
+                                      const Deadline &deadline) const;
+
+    /**
+     * @brief as newest, but waiting (if the time series is empty) only
+     * until the deadline (see wait_until).
+     * @returns the newest element with its index and timestamp, or nothing
+     * if the time series is still empty at the deadline (or SIGINT was
+     * received).
+     */
+    std::optional<Sample<T>> newest_until(const Deadline &deadline) const;
+
     size_t length() const;
     size_t max_length() const;
     bool has_changed_since_tag() const;
@@ -59,11 +107,136 @@ public:
     void append(const T &element);
     bool is_empty() const;
 
+    /**
+     * @brief returns the newest element, with its index and timestamp,
+     * read in a single critical section. Waits if the time series is empty.
+     */
+    Sample<T> newest() const;
+
+    /**
+     * @brief returns the element of the given index, with its timestamp,
+     * read in a single critical section. Waits if the element is not yet
+     * in the time series.
+     * @throws std::invalid_argument if the element is older than the oldest
+     * element.
+     */
+    Sample<T> at(const Index &timeindex) const;
+
+    /**
+     * @brief returns the elements from first to last (included), with
+     * their indexes and timestamps, read in a single critical section.
+     * Waits if last is not yet in the time series.
+     * @throws std::invalid_argument if first is older than the oldest
+     * element, or if last is smaller than first.
+     */
+    std::vector<Sample<T>> samples(const Index &first,
+                                   const Index &last) const;
+
+    /**
+     * @brief returns the element at the time time_ms (in milliseconds, as
+     * returned by timestamp_ms), computed from the two elements which
+     * timestamps surround it (see interpolation.hpp for the methods).
+     * The elements are located by binary search over the timestamps, and
+     * read in a single critical section. Waits if the time series is
+     * empty. For a time after the timestamp of the newest element, the
+     * newest element is returned (no extrapolation).
+     * @throws std::invalid_argument if time_ms is before the timestamp of
+     * the oldest element, or if the method is not supported by the
+     * element type.
+     * @throws std::logic_error if the time series has no timestamps
+     * (see policies.hpp).
+     */
+    T value_at_time(const Timestamp &time_ms,
+                    Interpolation method = Interpolation::LINEAR) const;
+
+    /**
+     * @brief returns the pages backing the memory in which
+     * the elements are stored (see memory_options.hpp).
+     */
+    PageBacking page_backing() const;
+
+    /**
+     * @brief returns how the memory in which the elements are stored was
+     * committed (see memory_options.hpp).
+     */
+    MemoryCommit memory_commit() const;
+
+    /**
+     * @brief returns the number of bytes of the elements and timestamps
+     * storage which are currently resident in RAM.
+     */
+    std::size_t resident_memory() const;
+
+    /**
+     * @brief returns the statistics of the period of the appends (see
+     * period_statistics.hpp), read without locking the time series.
+     * @throws std::logic_error if the period is not tracked
+     * (see the TrackPeriod policy in policies.hpp).
+     */
+    PeriodStatistics period_statistics() const;
+
+    /**
+     * @brief sets the deadline (in milliseconds) above which an interval
+     * between two appends is counted as a deadline miss (0: no deadline).
+     * Shared by all the instances of a multiprocess time series.
+     * @throws std::invalid_argument if deadline_ms is negative.
+     * @throws std::logic_error if the period is not tracked.
+     */
+    void set_period_deadline(double deadline_ms);
+
+    /**
+     * @brief sets the weight of the newest interval in the exponentially
+     * weighted mean and variance of the period (default 0.05).
+     * @throws std::invalid_argument if weight is not in ]0, 1].
+     * @throws std::logic_error if the period is not tracked.
+     */
+    void set_period_ewma_weight(double weight);
+
+    /**
+     * @brief resets the statistics of the period (keeping the deadline
+     * and the weight).
+     * @throws std::logic_error if the period is not tracked.
+     */
+    void reset_period_statistics();
+
 protected:
-    // in case of multiprocesses: will be used to keep
-    // indexes values aligned for all instances
-    virtual void read_indexes() const = 0;
-    virtual void write_indexes() = 0;
+    // copy the shared indexes (see indexes_ptr_) into the
+    // members below, and vice versa. To be called while holding the lock.
+    void read_indexes() const;
+    void write_indexes();
+
+    // to be called before writing the element newest + 1, and after
+    // write_indexes, so that the recovery from a process dying in between
+    // knows its slot may be torn (see Segment::recover). No-op for the
+    // layouts without recovery.
+    void begin_append();
+    void end_append();
+
+    // waits on the condition variable (or polls, depending on the
+    // wait policy). To be called while holding the lock.
+    void wait_on_condition(Lock<P> &lock) const;
+
+    // waits (releasing the lock) until the element of index timeindex is
+    // appended, the deadline or SIGINT (false returned for the two
+    // latter). To be called while holding the lock, after read_indexes.
+    bool wait_on_condition_until(Lock<P> &lock,
+                                 const Index &timeindex,
+                                 const Deadline &deadline) const;
+
+    // appends the element, returns its index and sets timestamp to its
+    // timestamp (NaN without timestamps)
+    Index append_element(const T &element, Timestamp &timestamp);
+
+    // index of the element in the storage
+    std::size_t slot(Index timeindex) const;
+
+    // element and timestamp of the index (assumed in the time series).
+    // To be called while holding the lock.
+    Sample<T> sample(Index timeindex) const;
+
+    // throws std::invalid_argument if max_length does not match
+    // the capacity policy
+    static std::size_t checked_max_length(std::size_t max_length);
 
     mutable Index start_timeindex_;
     mutable Index oldest_timeindex_;
@@ -83,7 +256,15 @@ protected:
     std::shared_ptr<Mutex<P> > mutex_ptr_;
     std::shared_ptr<ConditionVariable<P> > condition_ptr_;
     std::shared_ptr<Vector<P, T> > history_elements_ptr_;
+    // (nullptr if timestamps are disabled, see policies.hpp)
     std::shared_ptr<Vector<P, Timestamp> > history_timestamps_ptr_;
+    // indexes shared by all instances (i.e. in shared memory for
+    // multiprocesses time series). Written only while holding the lock,
+    // but the newest index may be read without locking (read only queries).
+    std::shared_ptr<Indexes> indexes_ptr_;
+    // statistics of the period of the appends, updated while holding the
+    // lock (nullptr if the period is not tracked, see policies.hpp)
+    std::shared_ptr<PeriodTracker> period_tracker_ptr_;
 
 private:
     std::thread signal_monitor_thread_;
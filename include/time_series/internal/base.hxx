@@ -1,8 +1,8 @@
 // Copyright (c) 2019 Max Planck Gesellschaft
 // Vincent Berenz
 
-template <typename P, typename T>
-void TimeSeriesBase<P, T>::throw_if_sigint_received() const
+template <typename P, typename T, typename Policies>
+void TimeSeriesBase<P, T, Policies>::throw_if_sigint_received() const
 {
     // only throw if throw_on_sigint_ is true
     if (throw_on_sigint_ &&
@@ -12,8 +12,8 @@ void TimeSeriesBase<P, T>::throw_if_sigint_received() const
     }
 }
 
-template <typename P, typename T>
-TimeSeriesBase<P, T>::TimeSeriesBase(Index start_timeindex,
+template <typename P, typename T, typename Policies>
+TimeSeriesBase<P, T, Policies>::TimeSeriesBase(Index start_timeindex,
                                      bool throw_on_sigint)
     : empty_(true), is_destructor_called_(false)
 {
@@ -32,8 +32,8 @@ TimeSeriesBase<P, T>::TimeSeriesBase(Index start_timeindex,
     }
 }
 
-template <typename P, typename T>
-TimeSeriesBase<P, T>::TimeSeriesBase(TimeSeriesBase<P, T>&& other) noexcept
+template <typename P, typename T, typename Policies>
+TimeSeriesBase<P, T, Policies>::TimeSeriesBase(TimeSeriesBase<P, T, Policies>&& other) noexcept
     : start_timeindex_(other.start_timeindex_),
       oldest_timeindex_(other.oldest_timeindex_),
       newest_timeindex_(other.newest_timeindex_),
@@ -45,11 +45,13 @@ TimeSeriesBase<P, T>::TimeSeriesBase(TimeSeriesBase<P, T>&& other) noexcept
     condition_ptr_ = std::move(other.condition_ptr_);
     history_elements_ptr_ = std::move(other.history_elements_ptr_);
     history_timestamps_ptr_ = std::move(other.history_timestamps_ptr_);
+    indexes_ptr_ = std::move(other.indexes_ptr_);
+    period_tracker_ptr_ = std::move(other.period_tracker_ptr_);
     signal_monitor_thread_ = std::move(other.signal_monitor_thread_);
 }
 
-template <typename P, typename T>
-TimeSeriesBase<P, T>::~TimeSeriesBase()
+template <typename P, typename T, typename Policies>
+TimeSeriesBase<P, T, Policies>::~TimeSeriesBase()
 {
     is_destructor_called_ = true;
     if (signal_monitor_thread_.joinable())
@@ -58,8 +60,49 @@ TimeSeriesBase<P, T>::~TimeSeriesBase()
     }
 }
 
-template <typename P, typename T>
-void TimeSeriesBase<P, T>::tag(const Index& timeindex)
+template <typename P, typename T, typename Policies>
+void TimeSeriesBase<P, T, Policies>::read_indexes() const
+{
+    start_timeindex_ = indexes_ptr_->start.load(std::memory_order_relaxed);
+    oldest_timeindex_ = indexes_ptr_->oldest.load(std::memory_order_relaxed);
+    newest_timeindex_ = indexes_ptr_->newest.load(std::memory_order_relaxed);
+    tagged_timeindex_ = indexes_ptr_->tagged.load(std::memory_order_relaxed);
+}
+
+template <typename P, typename T, typename Policies>
+void TimeSeriesBase<P, T, Policies>::write_indexes()
+{
+    // release: lock free readers observing the newest index
+    // also observe the corresponding element and timestamp
+    indexes_ptr_->start.store(start_timeindex_, std::memory_order_release);
+    indexes_ptr_->oldest.store(oldest_timeindex_, std::memory_order_release);
+    indexes_ptr_->tagged.store(tagged_timeindex_, std::memory_order_release);
+    indexes_ptr_->newest.store(newest_timeindex_, std::memory_order_release);
+}
+
+template <typename P, typename T, typename Policies>
+void TimeSeriesBase<P, T, Policies>::begin_append()
+{
+    if constexpr (HasRobustMutex<P>::value)
+    {
+        indexes_ptr_->writing.store(true, std::memory_order_relaxed);
+        // (the flag set before the slot gets written, as observed by a
+        // process recovering after this one died)
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+    }
+}
+
+template <typename P, typename T, typename Policies>
+void TimeSeriesBase<P, T, Policies>::end_append()
+{
+    if constexpr (HasRobustMutex<P>::value)
+    {
+        indexes_ptr_->writing.store(false, std::memory_order_release);
+    }
+}
+
+template <typename P, typename T, typename Policies>
+void TimeSeriesBase<P, T, Policies>::tag(const Index& timeindex)
 {
     Lock<P> lock(*this->mutex_ptr_);
     read_indexes();
@@ -67,90 +110,91 @@ void TimeSeriesBase<P, T>::tag(const Index& timeindex)
     write_indexes();
 }
 
-template <typename P, typename T>
-Index TimeSeriesBase<P, T>::tagged_timeindex() const
+template <typename P, typename T, typename Policies>
+Index TimeSeriesBase<P, T, Policies>::tagged_timeindex() const
 {
     Lock<P> lock(*this->mutex_ptr_);
     read_indexes();
     return tagged_timeindex_;
 }
 
-template <typename P, typename T>
-bool TimeSeriesBase<P, T>::has_changed_since_tag() const
+template <typename P, typename T, typename Policies>
+bool TimeSeriesBase<P, T, Policies>::has_changed_since_tag() const
 {
     Lock<P> lock(*this->mutex_ptr_);
     read_indexes();
     return tagged_timeindex_ != newest_timeindex_;
 }
 
-template <typename P, typename T>
-Index TimeSeriesBase<P, T>::newest_timeindex(bool wait) const
+// note: the read only queries below do not lock the mutex when
+// the time series is not empty. The start index never changes after
+// construction, and (when not empty) the oldest index and the length can
+// be derived from the newest index alone, so a single atomic load suffices.
+
+template <typename P, typename T, typename Policies>
+Index TimeSeriesBase<P, T, Policies>::newest_timeindex(bool wait) const
 {
+    Index newest = indexes_ptr_->newest.load(std::memory_order_acquire);
+    if (newest >= indexes_ptr_->start.load(std::memory_order_relaxed))
+    {
+        return newest;
+    }
+    if (!wait)
+    {
+        return EMPTY;
+    }
     Lock<P> lock(*this->mutex_ptr_);
     read_indexes();
-    if (wait)
+    while (newest_timeindex_ < oldest_timeindex_)
     {
-        while (newest_timeindex_ < oldest_timeindex_)
-        {
-            throw_if_sigint_received();
+        throw_if_sigint_received();
 
-            condition_ptr_->wait(lock);
-            read_indexes();
-        }
-    }
-    else
-    {
-        if (newest_timeindex_ < oldest_timeindex_)
-        {
-            return EMPTY;
-        }
+        wait_on_condition(lock);
+        read_indexes();
     }
     return newest_timeindex_;
 }
 
-template <typename P, typename T>
-Index TimeSeriesBase<P, T>::count_appended_elements() const
+template <typename P, typename T, typename Policies>
+Index TimeSeriesBase<P, T, Policies>::count_appended_elements() const
 {
-    Lock<P> lock(*this->mutex_ptr_);
-    read_indexes();
-    return newest_timeindex_ - start_timeindex_ + 1;
+    return indexes_ptr_->newest.load(std::memory_order_acquire) -
+           indexes_ptr_->start.load(std::memory_order_relaxed) + 1;
 }
 
-template <typename P, typename T>
-Index TimeSeriesBase<P, T>::oldest_timeindex(bool wait) const
+template <typename P, typename T, typename Policies>
+Index TimeSeriesBase<P, T, Policies>::oldest_timeindex(bool wait) const
 {
-    Lock<P> lock(*this->mutex_ptr_);
-    read_indexes();
-    if (wait)
+    Index newest = indexes_ptr_->newest.load(std::memory_order_acquire);
+    if (newest >= indexes_ptr_->start.load(std::memory_order_relaxed))
     {
-        while (newest_timeindex_ < oldest_timeindex_)
-        {
-            throw_if_sigint_received();
-
-            condition_ptr_->wait(lock);
-            read_indexes();
-        }
+        return indexes_ptr_->oldest.load(std::memory_order_acquire);
     }
-    else
+    if (!wait)
     {
-        if (newest_timeindex_ < oldest_timeindex_)
-        {
-            return EMPTY;
-        }
+        return EMPTY;
     }
+    Lock<P> lock(*this->mutex_ptr_);
+    read_indexes();
+    while (newest_timeindex_ < oldest_timeindex_)
+    {
+        throw_if_sigint_received();
 
+        wait_on_condition(lock);
+        read_indexes();
+    }
     return oldest_timeindex_;
 }
 
-template <typename P, typename T>
-T TimeSeriesBase<P, T>::newest_element() const
+template <typename P, typename T, typename Policies>
+T TimeSeriesBase<P, T, Policies>::newest_element() const
 {
     Index timeindex = newest_timeindex();
     return (*this)[timeindex];
 }
 
-template <typename P, typename T>
-T TimeSeriesBase<P, T>::operator[](const Index& timeindex) const
+template <typename P, typename T, typename Policies>
+T TimeSeriesBase<P, T, Policies>::operator[](const Index& timeindex) const
 {
     Lock<P> lock(*this->mutex_ptr_);
     read_indexes();
@@ -166,20 +210,24 @@ T TimeSeriesBase<P, T>::operator[](const Index& timeindex) const
     {
         throw_if_sigint_received();
 
-        condition_ptr_->wait(lock);
+        wait_on_condition(lock);
         read_indexes();
     }
 
     T element;
-    this->history_elements_ptr_->get(
-        timeindex % this->history_elements_ptr_->size(), element);
+    this->history_elements_ptr_->get(slot(timeindex), element);
 
     return element;
 }
 
-template <typename P, typename T>
-Timestamp TimeSeriesBase<P, T>::timestamp_ms(const Index& timeindex) const
+template <typename P, typename T, typename Policies>
+Timestamp TimeSeriesBase<P, T, Policies>::timestamp_ms(const Index& timeindex) const
 {
+    if constexpr (!Policies::clock::timestamps)
+    {
+        throw std::logic_error(
+            "time_series: timestamps are disabled (NoTimestamps policy)");
+    }
     Lock<P> lock(*this->mutex_ptr_);
     read_indexes();
     if (timeindex < oldest_timeindex_)
@@ -194,25 +242,24 @@ Timestamp TimeSeriesBase<P, T>::timestamp_ms(const Index& timeindex) const
     {
         throw_if_sigint_received();
 
-        condition_ptr_->wait(lock);
+        wait_on_condition(lock);
         read_indexes();
     }
 
     Timestamp timestamp;
-    this->history_timestamps_ptr_->get(
-        timeindex % this->history_timestamps_ptr_->size(), timestamp);
+    this->history_timestamps_ptr_->get(slot(timeindex), timestamp);
 
     return timestamp;
 }
 
-template <typename P, typename T>
-Timestamp TimeSeriesBase<P, T>::timestamp_s(const Index& timeindex) const
+template <typename P, typename T, typename Policies>
+Timestamp TimeSeriesBase<P, T, Policies>::timestamp_s(const Index& timeindex) const
 {
     return timestamp_ms(timeindex) / 1000.;
 }
 
-template <typename P, typename T>
-bool TimeSeriesBase<P, T>::wait_for_timeindex(
+template <typename P, typename T, typename Policies>
+bool TimeSeriesBase<P, T, Policies>::wait_for_timeindex(
     const Index& timeindex, const double& max_duration_s) const
 {
     Lock<P> lock(*this->mutex_ptr_);
@@ -225,30 +272,93 @@ bool TimeSeriesBase<P, T>::wait_for_timeindex(
                                     std::to_string(oldest_timeindex_) + ").");
     }
 
+    if (std::isfinite(max_duration_s))
+    {
+        // (durations of more than a century: no deadline)
+        Deadline deadline =
+            max_duration_s < 3e9
+                ? std::chrono::steady_clock::now() +
+                      std::chrono::duration_cast<Deadline::duration>(
+                          std::chrono::duration<double>(max_duration_s))
+                : Deadline::max();
+        return wait_on_condition_until(lock, timeindex, deadline);
+    }
     while (newest_timeindex_ < timeindex)
     {
-        if (std::isfinite(max_duration_s))
-        {
-            bool notified = condition_ptr_->wait_for(lock, max_duration_s);
-            if (!notified ||
-                signal_handler::SignalHandler::has_received_sigint())
-            {
-                return false;
-            }
-        }
-        else
-        {
-            throw_if_sigint_received();
-            condition_ptr_->wait(lock);
-        }
+        throw_if_sigint_received();
+        wait_on_condition(lock);
         read_indexes();
     }
     return true;
 }
 
-template <typename P, typename T>
-void TimeSeriesBase<P, T>::append(const T& element)
+template <typename P, typename T, typename Policies>
+bool TimeSeriesBase<P, T, Policies>::wait_until(const Index& timeindex,
+                                                const Deadline& deadline) const
+{
+    Lock<P> lock(*this->mutex_ptr_);
+    read_indexes();
+    if (timeindex < oldest_timeindex_)
+    {
+        throw std::invalid_argument("you tried to access time_series element " +
+                                    std::to_string(timeindex) +
+                                    " which is too old (oldest in buffer is " +
+                                    std::to_string(oldest_timeindex_) + ").");
+    }
+    return wait_on_condition_until(lock, timeindex, deadline);
+}
+
+template <typename P, typename T, typename Policies>
+std::optional<Sample<T>> TimeSeriesBase<P, T, Policies>::at_until(
+    const Index& timeindex, const Deadline& deadline) const
 {
+    Lock<P> lock(*this->mutex_ptr_);
+    read_indexes();
+    if (timeindex < oldest_timeindex_)
+    {
+        throw std::invalid_argument("you tried to access time_series element " +
+                                    std::to_string(timeindex) +
+                                    " which is too old (oldest in buffer is " +
+                                    std::to_string(oldest_timeindex_) + ").");
+    }
+    if (!wait_on_condition_until(lock, timeindex, deadline))
+    {
+        return std::nullopt;
+    }
+    return sample(timeindex);
+}
+
+template <typename P, typename T, typename Policies>
+std::optional<Sample<T>> TimeSeriesBase<P, T, Policies>::newest_until(
+    const Deadline& deadline) const
+{
+    Lock<P> lock(*this->mutex_ptr_);
+    read_indexes();
+    // (the time series is empty until its oldest element is appended)
+    if (!wait_on_condition_until(lock, oldest_timeindex_, deadline))
+    {
+        return std::nullopt;
+    }
+    return sample(newest_timeindex_);
+}
+
+template <typename P, typename T, typename Policies>
+void TimeSeriesBase<P, T, Policies>::append(const T& element)
+{
+    Timestamp timestamp;
+    append_element(element, timestamp);
+}
+
+template <typename P, typename T, typename Policies>
+Index TimeSeriesBase<P, T, Policies>::append_element(const T& element,
+                                                     Timestamp& timestamp)
+{
+    // notifying the condition variable is expensive (in particular
+    // for multiprocesses time series), so it is skipped when no reader
+    // is waiting. Checking for waiters while holding the lock is enough to
+    // avoid lost wake-ups, see specialized_classes.hpp.
+    bool has_waiters;
+    Index index;
     {
         Lock<P> lock(*this->mutex_ptr_);
 
@@ -256,48 +366,142 @@ void TimeSeriesBase<P, T>::append(const T& element)
         // element.print();
 
         read_indexes();
+        begin_append();
         newest_timeindex_++;
         if (newest_timeindex_ - oldest_timeindex_ + 1 >
-            static_cast<Index>(this->history_elements_ptr_->size()))
+            static_cast<Index>(max_length()))
         {
             oldest_timeindex_++;
         }
-        Index history_index =
-            newest_timeindex_ % this->history_elements_ptr_->size();
+        std::size_t history_index = slot(newest_timeindex_);
         this->history_elements_ptr_->set(history_index, element);
-        this->history_timestamps_ptr_->set(
-            history_index, real_time_tools::Timer::get_current_time_ms());
+        if constexpr (Policies::clock::timestamps)
+        {
+            timestamp = Policies::clock::now_ms();
+            this->history_timestamps_ptr_->set(history_index, timestamp);
+            if constexpr (Policies::period::enabled)
+            {
+                period_tracker_ptr_->update(timestamp);
+            }
+        }
+        else
+        {
+            timestamp = std::numeric_limits<Timestamp>::quiet_NaN();
+        }
         write_indexes();
+        end_append();
+        index = newest_timeindex_;
+        // (polling readers are never notified)
+        has_waiters =
+            Policies::wait::notify && condition_ptr_->has_waiters();
     }
-    condition_ptr_->notify_all();
+    if (has_waiters)
+    {
+        condition_ptr_->notify_all();
+    }
+    return index;
 }
 
-template <typename P, typename T>
-size_t TimeSeriesBase<P, T>::length() const
+template <typename P, typename T, typename Policies>
+size_t TimeSeriesBase<P, T, Policies>::length() const
 {
-    Lock<P> lock(*this->mutex_ptr_);
-    read_indexes();
-    return newest_timeindex_ - oldest_timeindex_ + 1;
+    Index appended = count_appended_elements();
+    return std::min(static_cast<size_t>(appended), max_length());
 }
 
-template <typename P, typename T>
-size_t TimeSeriesBase<P, T>::max_length() const
+template <typename P, typename T, typename Policies>
+size_t TimeSeriesBase<P, T, Policies>::max_length() const
 {
-    Lock<P> lock(*this->mutex_ptr_);
-    read_indexes();
+    if constexpr (Policies::capacity::max_length > 0)
+    {
+        return Policies::capacity::max_length;
+    }
+    // constant after construction, no need to lock
     return this->history_elements_ptr_->size();
 }
 
-template <typename P, typename T>
-bool TimeSeriesBase<P, T>::is_empty() const
+template <typename P, typename T, typename Policies>
+PageBacking TimeSeriesBase<P, T, Policies>::page_backing() const
+{
+    return this->history_elements_ptr_->page_backing();
+}
+
+template <typename P, typename T, typename Policies>
+MemoryCommit TimeSeriesBase<P, T, Policies>::memory_commit() const
+{
+    return this->history_elements_ptr_->memory_commit();
+}
+
+template <typename P, typename T, typename Policies>
+std::size_t TimeSeriesBase<P, T, Policies>::resident_memory() const
+{
+    std::size_t resident = this->history_elements_ptr_->resident_memory();
+    if constexpr (Policies::clock::timestamps)
+    {
+        resident += this->history_timestamps_ptr_->resident_memory();
+    }
+    return resident;
+}
+
+// throws std::logic_error if the period is not tracked
+template <typename Policies>
+void check_period_tracked()
+{
+    if constexpr (!Policies::period::enabled)
+    {
+        throw std::logic_error(
+            "time_series: the period of the appends is not tracked "
+            "(TrackPeriod policy)");
+    }
+}
+
+template <typename P, typename T, typename Policies>
+PeriodStatistics TimeSeriesBase<P, T, Policies>::period_statistics() const
+{
+    check_period_tracked<Policies>();
+    return period_tracker_ptr_->read();
+}
+
+template <typename P, typename T, typename Policies>
+void TimeSeriesBase<P, T, Policies>::set_period_deadline(double deadline_ms)
+{
+    check_period_tracked<Policies>();
+    if (!(deadline_ms >= 0))
+    {
+        throw std::invalid_argument(
+            "time_series: the period deadline should not be negative");
+    }
+    period_tracker_ptr_->deadline_ms = deadline_ms;
+}
+
+template <typename P, typename T, typename Policies>
+void TimeSeriesBase<P, T, Policies>::set_period_ewma_weight(double weight)
+{
+    check_period_tracked<Policies>();
+    if (!(weight > 0 && weight <= 1))
+    {
+        throw std::invalid_argument(
+            "time_series: the period ewma weight should be in ]0, 1]");
+    }
+    period_tracker_ptr_->ewma_weight = weight;
+}
+
+template <typename P, typename T, typename Policies>
+void TimeSeriesBase<P, T, Policies>::reset_period_statistics()
+{
+    check_period_tracked<Policies>();
+    Lock<P> lock(*this->mutex_ptr_);
+    period_tracker_ptr_->reset();
+}
+
+template <typename P, typename T, typename Policies>
+bool TimeSeriesBase<P, T, Policies>::is_empty() const
 {
     if (!empty_)
     {
         return false;
     }
-    Lock<P> lock(*this->mutex_ptr_);
-    read_indexes();
-    if (newest_timeindex_ < oldest_timeindex_)
+    if (count_appended_elements() == 0)
     {
         return true;
     }
@@ -305,8 +509,237 @@ bool TimeSeriesBase<P, T>::is_empty() const
     return false;
 }
 
-template <typename P, typename T>
-void TimeSeriesBase<P, T>::monitor_signal()
+template <typename P, typename T, typename Policies>
+Sample<T> TimeSeriesBase<P, T, Policies>::newest() const
+{
+    Lock<P> lock(*this->mutex_ptr_);
+    read_indexes();
+    while (newest_timeindex_ < oldest_timeindex_)
+    {
+        throw_if_sigint_received();
+
+        wait_on_condition(lock);
+        read_indexes();
+    }
+    return sample(newest_timeindex_);
+}
+
+template <typename P, typename T, typename Policies>
+Sample<T> TimeSeriesBase<P, T, Policies>::at(const Index& timeindex) const
+{
+    Lock<P> lock(*this->mutex_ptr_);
+    read_indexes();
+    if (timeindex < oldest_timeindex_)
+    {
+        throw std::invalid_argument("you tried to access time_series element " +
+                                    std::to_string(timeindex) +
+                                    " which is too old (oldest in buffer is " +
+                                    std::to_string(oldest_timeindex_) + ").");
+    }
+
+    while (newest_timeindex_ < timeindex)
+    {
+        throw_if_sigint_received();
+
+        wait_on_condition(lock);
+        read_indexes();
+    }
+    return sample(timeindex);
+}
+
+template <typename P, typename T, typename Policies>
+std::vector<Sample<T>> TimeSeriesBase<P, T, Policies>::samples(
+    const Index& first, const Index& last) const
+{
+    if (last < first)
+    {
+        throw std::invalid_argument("samples: invalid range " +
+                                    std::to_string(first) + " to " +
+                                    std::to_string(last));
+    }
+    Lock<P> lock(*this->mutex_ptr_);
+    read_indexes();
+    while (newest_timeindex_ < last)
+    {
+        throw_if_sigint_received();
+
+        wait_on_condition(lock);
+        read_indexes();
+    }
+    if (first < oldest_timeindex_)
+    {
+        throw std::invalid_argument("you tried to access time_series element " +
+                                    std::to_string(first) +
+                                    " which is too old (oldest in buffer is " +
+                                    std::to_string(oldest_timeindex_) + ").");
+    }
+    std::vector<Sample<T>> result;
+    result.reserve(last - first + 1);
+    for (Index index = first; index <= last; index++)
+    {
+        result.push_back(sample(index));
+    }
+    return result;
+}
+
+template <typename P, typename T, typename Policies>
+T TimeSeriesBase<P, T, Policies>::value_at_time(const Timestamp& time_ms,
+                                                Interpolation method) const
+{
+    if constexpr (!Policies::clock::timestamps)
+    {
+        throw std::logic_error(
+            "value_at_time: the time series has no timestamps");
+    }
+    else
+    {
+        T a, b;
+        double alpha = 0;
+        {
+            Lock<P> lock(*this->mutex_ptr_);
+            read_indexes();
+            while (newest_timeindex_ < oldest_timeindex_)
+            {
+                throw_if_sigint_received();
+
+                wait_on_condition(lock);
+                read_indexes();
+            }
+            auto timestamp = [this](Index timeindex) {
+                Timestamp t;
+                this->history_timestamps_ptr_->get(slot(timeindex), t);
+                return t;
+            };
+            if (time_ms < timestamp(oldest_timeindex_))
+            {
+                throw std::invalid_argument(
+                    "value_at_time: time older than the oldest element");
+            }
+            // newest element with a timestamp <= time_ms
+            Index low = oldest_timeindex_;
+            Index high = newest_timeindex_;
+            while (low < high)
+            {
+                Index middle = low + (high - low + 1) / 2;
+                if (timestamp(middle) <= time_ms)
+                {
+                    low = middle;
+                }
+                else
+                {
+                    high = middle - 1;
+                }
+            }
+            this->history_elements_ptr_->get(slot(low), a);
+            if (low == newest_timeindex_)
+            {
+                b = a;
+            }
+            else
+            {
+                this->history_elements_ptr_->get(slot(low + 1), b);
+                Timestamp t_a = timestamp(low);
+                Timestamp t_b = timestamp(low + 1);
+                if (t_b > t_a)
+                {
+                    alpha = static_cast<double>((time_ms - t_a) / (t_b - t_a));
+                }
+            }
+        }
+        return internal::interpolate(a, b, alpha, method);
+    }
+}
+
+template <typename P, typename T, typename Policies>
+Sample<T> TimeSeriesBase<P, T, Policies>::sample(Index timeindex) const
+{
+    Sample<T> sample;
+    sample.index = timeindex;
+    std::size_t history_index = slot(timeindex);
+    this->history_elements_ptr_->get(history_index, sample.element);
+    if constexpr (Policies::clock::timestamps)
+    {
+        this->history_timestamps_ptr_->get(history_index, sample.timestamp);
+    }
+    else
+    {
+        sample.timestamp = std::numeric_limits<Timestamp>::quiet_NaN();
+    }
+    return sample;
+}
+
+template <typename P, typename T, typename Policies>
+void TimeSeriesBase<P, T, Policies>::wait_on_condition(Lock<P>& lock) const
+{
+    if constexpr (Policies::wait::notify)
+    {
+        condition_ptr_->wait(lock);
+    }
+    else
+    {
+        // releases the lock while waiting: a new element is
+        // observed after at most one period
+        condition_ptr_->wait_for(lock, Policies::wait::period_s);
+    }
+}
+
+template <typename P, typename T, typename Policies>
+bool TimeSeriesBase<P, T, Policies>::wait_on_condition_until(
+    Lock<P>& lock, const Index& timeindex, const Deadline& deadline) const
+{
+    // each wait is bounded by the time remaining until the deadline
+    // (spurious wake ups and appends of older elements do not extend the
+    // wait), and by an hour (avoiding overflows in the conversions of the
+    // condition variables)
+    constexpr double max_wait_s = 3600.;
+    while (newest_timeindex_ < timeindex)
+    {
+        double remaining_s = std::chrono::duration<double>(
+                                 deadline - std::chrono::steady_clock::now())
+                                 .count();
+        if (remaining_s <= 0 ||
+            signal_handler::SignalHandler::has_received_sigint())
+        {
+            return false;
+        }
+        double wait_s = std::min(remaining_s, max_wait_s);
+        if constexpr (!Policies::wait::notify)
+        {
+            wait_s = std::min(wait_s, Policies::wait::period_s);
+        }
+        condition_ptr_->wait_for(lock, wait_s);
+        read_indexes();
+    }
+    return true;
+}
+
+template <typename P, typename T, typename Policies>
+std::size_t TimeSeriesBase<P, T, Policies>::slot(Index timeindex) const
+{
+    if constexpr (Policies::capacity::max_length > 0)
+    {
+        return timeindex % static_cast<Index>(Policies::capacity::max_length);
+    }
+    return timeindex % this->history_elements_ptr_->size();
+}
+
+template <typename P, typename T, typename Policies>
+std::size_t TimeSeriesBase<P, T, Policies>::checked_max_length(
+    std::size_t max_length)
+{
+    if (Policies::capacity::max_length > 0 &&
+        max_length != Policies::capacity::max_length)
+    {
+        throw std::invalid_argument(
+            "time_series: max length " + std::to_string(max_length) +
+            " does not match the fixed capacity " +
+            std::to_string(Policies::capacity::max_length));
+    }
+    return max_length;
+}
+
+template <typename P, typename T, typename Policies>
+void TimeSeriesBase<P, T, Policies>::monitor_signal()
 {
     constexpr double SLEEP_DURATION_MS = 100;
 
@@ -316,6 +749,12 @@ void TimeSeriesBase<P, T>::monitor_signal()
     std::shared_ptr<ConditionVariable<P> > local_condition_ptr = condition_ptr_;
     while (!local_condition_ptr)
     {
+        // the constructor of the subclass may have thrown
+        // before setting the condition variable
+        if (is_destructor_called_)
+        {
+            return;
+        }
         local_condition_ptr = condition_ptr_;
         real_time_tools::Timer::sleep_ms(SLEEP_DURATION_MS);
     }
@@ -0,0 +1,109 @@
+// Copyright (c) 2019 Max Planck Gesellschaft
+// Vincent Berenz
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace time_series
+{
+namespace internal
+{
+// Encoders used by CompressedTimeSeries (see compressed_time_series.hpp),
+// based on the compression scheme of Facebook's Gorilla
+// (Pelkonen et al., "Gorilla: A Fast, Scalable, In-Memory Time Series
+// Database", VLDB 2015):
+// - timestamps (integers) are encoded as the difference between
+//   consecutive deltas (delta-of-delta), which is zero for a regular period
+// - values (bit patterns) are encoded as the xor with the previous value,
+//   storing only the meaningful bits.
+
+// stream of bits, appended by BitWriter and read by BitReader
+typedef std::vector<std::uint64_t> Bits;
+
+class BitWriter
+{
+public:
+    // (clears bits)
+    BitWriter(Bits &bits);
+    // writes the nb_bits (0 to 64) lowest bits of value
+    void write(std::uint64_t value, int nb_bits);
+    // number of bits written so far in the stream
+    std::size_t size() const;
+    // clears the stream, for writing a new one
+    void clear();
+
+private:
+    Bits &bits_;
+    // bits already used in the last word of bits_ (0: new word needed)
+    int used_;
+};
+
+class BitReader
+{
+public:
+    BitReader(const Bits &bits);
+    std::uint64_t read(int nb_bits);
+
+private:
+    const Bits &bits_;
+    std::size_t position_;
+};
+
+class DeltaOfDeltaEncoder
+{
+public:
+    DeltaOfDeltaEncoder();
+    void encode(std::int64_t value, BitWriter &writer);
+    void reset();
+
+private:
+    std::size_t count_;
+    std::int64_t previous_;
+    std::int64_t delta_;
+};
+
+class DeltaOfDeltaDecoder
+{
+public:
+    DeltaOfDeltaDecoder();
+    std::int64_t decode(BitReader &reader);
+
+private:
+    std::size_t count_;
+    std::int64_t previous_;
+    std::int64_t delta_;
+};
+
+class XorEncoder
+{
+public:
+    XorEncoder();
+    void encode(std::uint64_t value, BitWriter &writer);
+    void reset();
+
+private:
+    bool first_;
+    std::uint64_t previous_;
+    // meaningful bits window of the previous (non zero) xor
+    int leading_;
+    int trailing_;
+};
+
+class XorDecoder
+{
+public:
+    XorDecoder();
+    std::uint64_t decode(BitReader &reader);
+
+private:
+    bool first_;
+    std::uint64_t previous_;
+    int leading_;
+    int trailing_;
+};
+
+}  // namespace internal
+}  // namespace time_series
@@ -0,0 +1,37 @@
+// Copyright (c) 2019 Max Planck Gesellschaft
+// Vincent Berenz
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+
+namespace time_series
+{
+namespace internal
+{
+// eventfd signaled on new elements (see TimeSeries::event_fd and
+// Reactor::event_fd). The file descriptor is created on the first call
+// to get, notify being a single atomic load until then.
+class EventFd
+{
+public:
+    EventFd();
+    ~EventFd();
+    EventFd(const EventFd &) = delete;
+    EventFd &operator=(const EventFd &) = delete;
+
+    // returns the (non blocking) file descriptor, creating it if needed.
+    // Throws std::runtime_error if the eventfd can not be created.
+    int get();
+
+    // makes the file descriptor readable (if created)
+    void notify();
+
+private:
+    std::mutex mutex_;
+    std::atomic<int> fd_;
+};
+
+}  // namespace internal
+}  // namespace time_series
@@ -0,0 +1,45 @@
+// Copyright (c) 2019 Max Planck Gesellschaft
+// Vincent Berenz
+
+#pragma once
+
+#include <atomic>
+
+#include "time_series/interface.hpp"
+#include "time_series/internal/aligned_allocator.hpp"
+
+namespace time_series
+{
+namespace internal
+{
+// The indexes of a time series, packed in a single cache line.
+// For multiprocesses time series, an instance lives in shared memory
+// (hence the requirement for address free, lock free atomics).
+// Writes are performed while holding the time series mutex, but reads
+// of newest may be performed without locking (see TimeSeriesBase).
+struct alignas(CACHE_LINE_SIZE) Indexes
+{
+    Indexes(Index start_timeindex = 0)
+        : start(start_timeindex),
+          oldest(start_timeindex),
+          newest(start_timeindex - 1),
+          tagged(start_timeindex - 1),
+          writing(false)
+    {
+    }
+    std::atomic<Index> start;
+    std::atomic<Index> oldest;
+    std::atomic<Index> newest;
+    std::atomic<Index> tagged;
+    // true while the element newest + 1 is being appended (only
+    // maintained by the layouts with a robust mutex, see Segment::recover)
+    std::atomic<bool> writing;
+};
+
+static_assert(std::atomic<Index>::is_always_lock_free,
+              "time_series requires lock free atomic indexes");
+static_assert(sizeof(Indexes) == CACHE_LINE_SIZE,
+              "time_series indexes expected to fit a cache line");
+
+}  // namespace internal
+}  // namespace time_series
@@ -0,0 +1,69 @@
+// Copyright (c) 2019 Max Planck Gesellschaft
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "time_series/memory_options.hpp"
+
+namespace time_series
+{
+namespace internal
+{
+constexpr std::size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// mount point of hugetlbfs on which multiprocesses time series
+// requesting huge pages create their shared memory
+static const std::string hugetlbfs_mount("/dev/hugepages");
+
+inline std::size_t huge_page_ceil(std::size_t size)
+{
+    return ((size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE) * HUGE_PAGE_SIZE;
+}
+
+// requested or obtained properties of some memory
+// (see memory_options.hpp)
+struct Allocation
+{
+    PageBacking page_backing;
+    MemoryCommit commit;
+};
+
+/**
+ * Allocates (process private) memory aligned on alignment, backed
+ * by pages of the requested type and committed as requested, if possible
+ * (see memory_options.hpp).
+ * @param[out] obtained  what was actually obtained, to be passed to
+ *                       deallocate_memory
+ * @throws std::bad_alloc on failure
+ */
+void *allocate_memory(std::size_t size,
+                      std::size_t alignment,
+                      const Allocation &requested,
+                      Allocation &obtained);
+
+void deallocate_memory(void *memory,
+                       std::size_t size,
+                       std::size_t alignment,
+                       const Allocation &obtained);
+
+/**
+ * Faults in (writable) all the pages of the memory, without modifying
+ * its content. If lock is true, the memory is also locked.
+ * Returns the commit mode obtained (PREFAULT if the memory could not be
+ * locked).
+ */
+MemoryCommit prefault_memory(void *memory, std::size_t size, bool lock);
+
+// number of bytes of the memory which are resident in RAM
+std::size_t resident_memory(const void *memory, std::size_t size);
+
+// number of bytes of RAM used by the POSIX shared memory object
+std::size_t shared_memory_footprint(const std::string &shm_id);
+
+// true if path is on a mounted hugetlbfs
+bool is_hugetlbfs(const std::string &path);
+
+}  // namespace internal
+}  // namespace time_series
@@ -0,0 +1,163 @@
+// Copyright (c) 2019 Max Planck Gesellschaft
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+#include "time_series/interface.hpp"
+#include "time_series/period_statistics.hpp"
+
+namespace time_series
+{
+namespace internal
+{
+// Running statistics of the period of the appends of a time series
+// (see the TrackPeriod policy). For multiprocesses time series, an instance
+// lives in shared memory (hence the atomics).
+// update and reset are called while holding the time series mutex (single
+// writer). read does not lock: the statistics are protected by a sequence
+// counter (seqlock), odd while an update is in progress, readers retrying
+// until they read the same even value before and after the statistics.
+struct PeriodTracker
+{
+    static constexpr double DEFAULT_EWMA_WEIGHT = 0.05;
+
+    PeriodTracker()
+        : sequence(0), deadline_ms(0), ewma_weight(DEFAULT_EWMA_WEIGHT)
+    {
+        reset();
+    }
+
+    // timestamp: of the element being appended
+    void update(Timestamp timestamp)
+    {
+        double previous = previous_ms.load(std::memory_order_relaxed);
+        previous_ms.store(timestamp, std::memory_order_relaxed);
+        double period = timestamp - previous;
+        if (!has_previous.load(std::memory_order_relaxed))
+        {
+            has_previous.store(true, std::memory_order_relaxed);
+            return;
+        }
+        begin_write();
+        std::int64_t n = count.load(std::memory_order_relaxed);
+        if (n == 0)
+        {
+            mean_ms.store(period, std::memory_order_relaxed);
+            min_ms.store(period, std::memory_order_relaxed);
+            max_ms.store(period, std::memory_order_relaxed);
+        }
+        else
+        {
+            // exponentially weighted mean and variance
+            double weight = ewma_weight.load(std::memory_order_relaxed);
+            double mean = mean_ms.load(std::memory_order_relaxed);
+            double delta = period - mean;
+            mean_ms.store(mean + weight * delta, std::memory_order_relaxed);
+            variance_ms2.store(
+                (1. - weight) *
+                    (variance_ms2.load(std::memory_order_relaxed) +
+                     weight * delta * delta),
+                std::memory_order_relaxed);
+            double min = min_ms.load(std::memory_order_relaxed);
+            double max = max_ms.load(std::memory_order_relaxed);
+            min_ms.store(std::min(min, period), std::memory_order_relaxed);
+            max_ms.store(std::max(max, period), std::memory_order_relaxed);
+        }
+        count.store(n + 1, std::memory_order_relaxed);
+        double deadline = deadline_ms.load(std::memory_order_relaxed);
+        if (deadline > 0 && period > deadline)
+        {
+            deadline_misses.store(
+                deadline_misses.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+        }
+        end_write();
+    }
+
+    // (the deadline and the weight are kept)
+    void reset()
+    {
+        begin_write();
+        has_previous.store(false, std::memory_order_relaxed);
+        previous_ms.store(0, std::memory_order_relaxed);
+        count.store(0, std::memory_order_relaxed);
+        mean_ms.store(0, std::memory_order_relaxed);
+        variance_ms2.store(0, std::memory_order_relaxed);
+        min_ms.store(0, std::memory_order_relaxed);
+        max_ms.store(0, std::memory_order_relaxed);
+        deadline_misses.store(0, std::memory_order_relaxed);
+        end_write();
+    }
+
+    // after a writer died while holding the time series mutex (see
+    // Segment::recover): if it died in the middle of update or reset,
+    // the sequence counter is odd (read would spin forever) and the
+    // statistics may be torn, so they are reset
+    void recover()
+    {
+        std::uint64_t current = sequence.load(std::memory_order_relaxed);
+        if (current & 1)
+        {
+            sequence.store(current + 1, std::memory_order_release);
+            reset();
+        }
+    }
+
+    PeriodStatistics read() const
+    {
+        PeriodStatistics statistics;
+        std::uint64_t before, after;
+        do
+        {
+            before = sequence.load(std::memory_order_acquire);
+            statistics.count = count.load(std::memory_order_relaxed);
+            statistics.mean_ms = mean_ms.load(std::memory_order_relaxed);
+            statistics.variance_ms2 =
+                variance_ms2.load(std::memory_order_relaxed);
+            statistics.min_ms = min_ms.load(std::memory_order_relaxed);
+            statistics.max_ms = max_ms.load(std::memory_order_relaxed);
+            statistics.deadline_misses =
+                deadline_misses.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+        statistics.deadline_ms = deadline_ms.load(std::memory_order_relaxed);
+        return statistics;
+    }
+
+    std::atomic<std::uint64_t> sequence;
+    std::atomic<bool> has_previous;
+    std::atomic<double> previous_ms;
+    std::atomic<std::int64_t> count;
+    std::atomic<double> mean_ms;
+    std::atomic<double> variance_ms2;
+    std::atomic<double> min_ms;
+    std::atomic<double> max_ms;
+    std::atomic<std::int64_t> deadline_misses;
+    // settings (may be changed at any time, see TimeSeriesBase)
+    std::atomic<double> deadline_ms;
+    std::atomic<double> ewma_weight;
+
+private:
+    void begin_write()
+    {
+        sequence.store(sequence.load(std::memory_order_relaxed) + 1,
+                       std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+    void end_write()
+    {
+        sequence.store(sequence.load(std::memory_order_relaxed) + 1,
+                       std::memory_order_release);
+    }
+};
+
+static_assert(std::atomic<double>::is_always_lock_free &&
+                  std::atomic<std::int64_t>::is_always_lock_free,
+              "time_series requires lock free atomic statistics");
+
+}  // namespace internal
+}  // namespace time_series
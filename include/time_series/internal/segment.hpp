@@ -0,0 +1,203 @@
+// Copyright (c) 2019 Max Planck Gesellschaft
+// Vincent Berenz
+
+#pragma once
+
+#include <pthread.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <typeinfo>
+
+#include "time_series/interface.hpp"
+#include "time_series/lock_options.hpp"
+#include "time_series/internal/indexes.hpp"
+#include "time_series/internal/period_tracker.hpp"
+#include "time_series/internal/shared_memory_region.hpp"
+
+namespace time_series
+{
+namespace internal
+{
+// Single segment layout of multiprocesses time series: all the data of
+// a time series lives in a single shared memory object
+// (named segment_id + shm_segment), so that a follower attaches with a single
+// shm_open and mmap:
+//
+// | SegmentHeader | timestamps (max_length) | element slots (max_length) |
+// | payload arena (optional, see MultiprocessPayloadTimeSeries) |
+//
+// each part starting on a cache line. Without timestamps (NoTimestamps
+// policy), the timestamps part is empty.
+
+static const std::string shm_segment("_segment");
+
+// written last by the leader, once the segment is fully initialized
+constexpr std::uint64_t SEGMENT_MAGIC = 0x54494d4553455253;  // "TIMESERS"
+constexpr std::uint32_t SEGMENT_VERSION = 6;
+
+struct SegmentHeader
+{
+    // metadata (constant after initialization)
+    std::atomic<std::uint64_t> magic;
+    std::uint32_t version;
+    std::uint64_t type_hash;
+    std::uint64_t max_length;
+    std::uint64_t slot_size;
+    // false: no timestamps part (the timestamps offset is the slots offset)
+    bool timestamps;
+    std::uint64_t timestamps_offset;
+    std::uint64_t slots_offset;
+    std::uint64_t arena_offset;
+    std::uint64_t arena_size;
+    std::uint64_t segment_size;
+    PageBacking page_backing;
+    // process of the current leader (see Segment::reattach)
+    std::atomic<std::int32_t> leader_pid;
+    // indexes (in their own cache line)
+    Indexes indexes;
+    // synchronization primitives (process shared, the mutex being
+    // robust: see Segment::recover).
+    // waiters: see ConditionVariable in specialized_classes.hpp
+    alignas(CACHE_LINE_SIZE) pthread_mutex_t mutex;
+    pthread_cond_t condition;
+    long waiters;
+    // total number of bytes written in the arena (written while
+    // holding the mutex)
+    std::uint64_t arena_head;
+    // statistics of the period of the appends (updated only with the
+    // TrackPeriod policy, see policies.hpp)
+    alignas(CACHE_LINE_SIZE) PeriodTracker period_tracker;
+};
+
+// hash used by followers to check they use the same element type
+// as the leader. Based on the (compiler specific) name of the type, so
+// the leader and followers are expected to be compiled with the same
+// compiler.
+template <typename T>
+std::uint64_t type_hash()
+{
+    // FNV-1a
+    std::uint64_t hash = 0xcbf29ce484222325;
+    for (const char *c = typeid(T).name(); *c != '\0'; c++)
+    {
+        hash = (hash ^ static_cast<unsigned char>(*c)) * 0x100000001b3;
+    }
+    return (hash ^ sizeof(T)) * 0x100000001b3;
+}
+
+/**
+ * A mapped single segment (see layout above).
+ */
+class Segment
+{
+public:
+    /**
+     * Creates (and initializes) the segment. A segment of the same id
+     * already existing is first unlinked.
+     * @param timestamps if false, no memory is reserved for the timestamps
+     *        of the elements (NoTimestamps policy)
+     * @param clear_on_destruction if true, the shared memory is unlinked
+     *        when the instance is destroyed.
+     * @param arena_size size (in bytes) of the payload arena (0: no arena)
+     * @param lock_protocol protocol of the mutex (see lock_options.hpp)
+     * @throws std::runtime_error if the protocol is not supported
+     */
+    static std::shared_ptr<Segment> create(const std::string &segment_id,
+                                           std::size_t max_length,
+                                           std::size_t slot_size,
+                                           bool timestamps,
+                                           std::uint64_t type_hash,
+                                           Index start_timeindex,
+                                           bool clear_on_destruction,
+                                           PageBacking page_backing,
+                                           MemoryCommit commit,
+                                           std::size_t arena_size = 0,
+                                           LockProtocol lock_protocol =
+                                               LockProtocol::DEFAULT);
+
+    /**
+     * Attaches to a segment created by a leader.
+     * @throws std::runtime_error if the segment does not exist, is not
+     * initialized yet, or was created for another element type.
+     */
+    static std::shared_ptr<Segment> attach(
+        const std::string &segment_id,
+        std::uint64_t type_hash,
+        MemoryCommit commit = MemoryCommit::DEFAULT);
+
+    /**
+     * Attaches to a segment as its new leader (the segment being unlinked
+     * on destruction), e.g. after the previous leader crashed. The
+     * elements, indexes and synchronization primitives are kept, so that
+     * the new leader appends after the newest element.
+     * @throws std::runtime_error as attach, or if the previous leader
+     * process is still running.
+     */
+    static std::shared_ptr<Segment> reattach(
+        const std::string &segment_id,
+        std::uint64_t type_hash,
+        MemoryCommit commit = MemoryCommit::DEFAULT);
+
+    /**
+     * Maps a segment without checking the type of its elements, for
+     * reading its header only (see SegmentMonitor).
+     * @throws std::runtime_error as attach
+     */
+    static std::shared_ptr<Segment> inspect(const std::string &segment_id);
+
+    //! unlink the corresponding shared memory object
+    static void clear(const std::string &segment_id);
+
+    /**
+     * Restores the consistency of the indexes after a process died while
+     * holding the (robust) mutex, e.g. in the middle of an append. To be
+     * called by the process which acquired the mutex with EOWNERDEAD,
+     * before making it consistent (see Lock in specialized_classes.hpp).
+     * If the dead process was appending, the element being appended is
+     * discarded, as well as the oldest element if the ring is full (its
+     * slot may have been partially overwritten). The period statistics
+     * are reset if the dead process was updating them.
+     */
+    void recover() const;
+
+    SegmentHeader *header() const
+    {
+        return static_cast<SegmentHeader *>(region_->data());
+    }
+    // (nullptr if the segment has no timestamps)
+    Timestamp *timestamps() const
+    {
+        if (!header()->timestamps)
+        {
+            return nullptr;
+        }
+        return reinterpret_cast<Timestamp *>(
+            static_cast<char *>(region_->data()) + header()->timestamps_offset);
+    }
+    char *slots() const
+    {
+        return static_cast<char *>(region_->data()) + header()->slots_offset;
+    }
+    char *arena() const
+    {
+        return static_cast<char *>(region_->data()) + header()->arena_offset;
+    }
+    PageBacking page_backing() const
+    {
+        return region_->page_backing();
+    }
+    MemoryCommit memory_commit() const
+    {
+        return region_->memory_commit();
+    }
+
+private:
+    Segment(std::unique_ptr<SharedMemoryRegion> region);
+    std::unique_ptr<SharedMemoryRegion> region_;
+};
+
+}  // namespace internal
+}  // namespace time_series
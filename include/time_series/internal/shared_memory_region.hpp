@@ -0,0 +1,106 @@
+// Copyright (c) 2019 Max Planck Gesellschaft
+// Vincent Berenz
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "time_series/memory_options.hpp"
+
+namespace time_series
+{
+namespace internal
+{
+/**
+ * A (POSIX) shared memory object mapped in the memory of the process.
+ * Unlike the segments of the shared_memory package, a region has no
+ * segment manager: it is a plain chunk of memory in which the users
+ * may placement-new objects (which must then be address free).
+ */
+class SharedMemoryRegion
+{
+public:
+    /**
+     * @param region_id  name of the shared memory object
+     * @param size       size (in bytes) of the region
+     * @param create     if true, the object is created (or, if it already
+     *                   exists, resized). Otherwise it is expected to exist
+     *                   and to be at least of the requested size (if size
+     *                   is 0, the full existing object is mapped).
+     * @param clear_on_destruction if true, the shared memory object is
+     *                   unlinked on destruction.
+     * @param page_backing (if create is true) requested pages, see
+     *                   PageBacking. If huge pages are used, the region is
+     *                   a file of the hugetlbfs mount point (see memory.hpp)
+     *                   rather than a POSIX shared memory object, and its
+     *                   size is rounded up to a multiple of 2MB.
+     * @throws std::runtime_error if the region can not be created or
+     *                   mapped, or if create is false and no (large enough)
+     *                   region exists.
+     */
+    SharedMemoryRegion(const std::string& region_id,
+                       std::size_t size,
+                       bool create,
+                       bool clear_on_destruction,
+                       PageBacking page_backing = PageBacking::DEFAULT_PAGES);
+    ~SharedMemoryRegion();
+
+    SharedMemoryRegion(const SharedMemoryRegion&) = delete;
+    SharedMemoryRegion& operator=(const SharedMemoryRegion&) = delete;
+
+    void* data() const
+    {
+        return data_;
+    }
+    std::size_t size() const
+    {
+        return size_;
+    }
+    PageBacking page_backing() const
+    {
+        return page_backing_;
+    }
+
+    /**
+     * advises the kernel to use transparent huge pages for the region
+     * (a follower should call this if the leader did).
+     * Returns false if transparent huge pages are not supported.
+     */
+    bool advise_huge_pages();
+
+    /**
+     * prefaults (and locks, if commit is LOCK) the region in the memory
+     * of this process. Returns (and stores, see memory_commit) the commit
+     * mode obtained. DEFAULT and LAZY have no effect
+     * (the shared memory is lazily committed).
+     */
+    MemoryCommit commit(MemoryCommit commit);
+    MemoryCommit memory_commit() const
+    {
+        return memory_commit_;
+    }
+
+    //! whether the shared memory object is unlinked on destruction
+    void set_clear_on_destruction(bool clear_on_destruction)
+    {
+        clear_on_destruction_ = clear_on_destruction;
+    }
+
+    //! unlink the shared memory object (no effect if it does not exist)
+    static void clear(const std::string& region_id);
+
+private:
+    void create(PageBacking page_backing);
+    void open();
+
+    std::string region_id_;
+    std::size_t size_;
+    bool clear_on_destruction_;
+    void* data_;
+    PageBacking page_backing_;
+    MemoryCommit memory_commit_;
+};
+
+}  // namespace internal
+}  // namespace time_series
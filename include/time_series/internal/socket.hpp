@@ -0,0 +1,41 @@
+// Copyright (c) 2019 Max Planck Gesellschaft
+// Vincent Berenz
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace time_series
+{
+namespace internal
+{
+// Minimal blocking stream sockets (TCP or UNIX domain) used by the stream
+// bridge (see stream_bridge.hpp). All functions throw std::runtime_error
+// on failure.
+
+// returns a socket listening on the port (0: any free port, see
+// bound_port) of the IPv4 address of host ("0.0.0.0": all interfaces)
+int listen_tcp(const std::string& host, int port);
+// returns a socket listening on the path (an existing file is replaced)
+int listen_unix(const std::string& path);
+// port a TCP socket is bound to
+int bound_port(int fd);
+// waits for a connection. Returns -1 once the listening socket has been
+// shut down (see shutdown_socket)
+int accept_connection(int listen_fd);
+int connect_tcp(const std::string& host, int port);
+int connect_unix(const std::string& path);
+// returns false if the connection was closed
+bool send_all(int fd, const void* data, std::size_t size);
+// returns false if the connection was closed
+bool receive_all(int fd, void* data, std::size_t size);
+// returns true if the peer closed the connection (for peers which never
+// send any data, e.g. stream bridge subscribers). Does not block.
+bool peer_closed(int fd);
+// unblocks the threads blocked on the socket
+void shutdown_socket(int fd);
+void close_socket(int fd);
+
+}  // namespace internal
+}  // namespace time_series
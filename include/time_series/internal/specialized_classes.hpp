@@ -3,14 +3,32 @@
 
 #pragma once
 
+#include <pthread.h>
+#include <time.h>
+
+#include <cerrno>
 #include <condition_variable>
+#include <cstring>
+#include <memory>
 #include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
 #include <vector>
 
 #include "shared_memory/array.hpp"
 #include "shared_memory/condition_variable.hpp"
 #include "shared_memory/lock.hpp"
 #include "shared_memory/mutex.hpp"
+#include "shared_memory/serializer.hpp"
+
+#include "time_series/element_storage.hpp"
+#include "time_series/lock_options.hpp"
+#include "time_series/internal/aligned_allocator.hpp"
+#include "time_series/internal/segment.hpp"
 
 namespace time_series
 {
@@ -18,6 +36,13 @@ namespace internal
 {
 typedef std::integral_constant<int, 0> SingleProcess;
 typedef std::integral_constant<int, 1> MultiProcesses;
+// multiprocesses, all data in a single shared memory segment
+// (see segment.hpp)
+typedef std::integral_constant<int, 2> MultiProcessesSingleSegment;
+// multiprocesses, single segment with variable size payloads stored
+// in an arena (see multiprocess_payload_time_series.hpp). Same
+// synchronization primitives as MultiProcessesSingleSegment.
+typedef std::integral_constant<int, 3> MultiProcessesPayloadArena;
 
 // ------- Mutex ------- //
 
@@ -26,14 +51,81 @@ class Mutex
 {
 };
 
+// pthread mutex of the given protocol, usable (as a BasicLockable) with
+// std::unique_lock and std::condition_variable_any. Used by the single
+// process time series only for the protocols std::mutex does not support.
+class PthreadMutex
+{
+public:
+    /**
+     * @throws std::runtime_error if the protocol is not supported
+     */
+    PthreadMutex(LockProtocol lock_protocol)
+    {
+        pthread_mutexattr_t attributes;
+        pthread_mutexattr_init(&attributes);
+        int r = 0;
+        if (lock_protocol == LockProtocol::PRIORITY_INHERITANCE)
+        {
+            r = pthread_mutexattr_setprotocol(&attributes,
+                                              PTHREAD_PRIO_INHERIT);
+        }
+        if (r == 0)
+        {
+            r = pthread_mutex_init(&mutex_, &attributes);
+        }
+        pthread_mutexattr_destroy(&attributes);
+        if (r != 0)
+        {
+            throw std::runtime_error("time_series: failed to initialize a " +
+                                     to_string(lock_protocol) + " mutex (" +
+                                     std::string(std::strerror(r)) + ")");
+        }
+    }
+    ~PthreadMutex()
+    {
+        pthread_mutex_destroy(&mutex_);
+    }
+    PthreadMutex(const PthreadMutex &) = delete;
+    PthreadMutex &operator=(const PthreadMutex &) = delete;
+    void lock()
+    {
+        int r = pthread_mutex_lock(&mutex_);
+        if (r != 0)
+        {
+            throw std::system_error(r, std::generic_category());
+        }
+    }
+    bool try_lock()
+    {
+        return pthread_mutex_trylock(&mutex_) == 0;
+    }
+    void unlock()
+    {
+        pthread_mutex_unlock(&mutex_);
+    }
+
+private:
+    pthread_mutex_t mutex_;
+};
+
 template <>
 class Mutex<SingleProcess>
 {
 public:
-    Mutex()
+    /**
+     * @throws std::runtime_error if the protocol is not supported
+     */
+    Mutex(LockProtocol lock_protocol = LockProtocol::DEFAULT)
     {
+        if (lock_protocol != LockProtocol::DEFAULT)
+        {
+            protocol_mutex.reset(new PthreadMutex(lock_protocol));
+        }
     }
     std::mutex mutex;
+    // used instead of mutex for the other protocols (nullptr by default)
+    std::unique_ptr<PthreadMutex> protocol_mutex;
 };
 
 template <>
@@ -47,6 +139,43 @@ public:
     shared_memory::Mutex mutex;
 };
 
+template <>
+class Mutex<MultiProcessesSingleSegment>
+{
+public:
+    Mutex(std::shared_ptr<Segment> segment)
+        : segment(segment), mutex(&segment->header()->mutex)
+    {
+    }
+    std::shared_ptr<Segment> segment;
+    pthread_mutex_t *mutex;
+};
+
+template <>
+class Mutex<MultiProcessesPayloadArena>
+    : public Mutex<MultiProcessesSingleSegment>
+{
+public:
+    using Mutex<MultiProcessesSingleSegment>::Mutex;
+};
+
+// true for the layouts which mutex is robust, i.e. which recover from
+// a process dying while holding it (see Segment::recover)
+template <typename P>
+struct HasRobustMutex : std::false_type
+{
+};
+
+template <>
+struct HasRobustMutex<MultiProcessesSingleSegment> : std::true_type
+{
+};
+
+template <>
+struct HasRobustMutex<MultiProcessesPayloadArena> : std::true_type
+{
+};
+
 // ------- Lock ------- //
 
 template <typename P>
@@ -58,10 +187,19 @@ template <>
 class Lock<SingleProcess>
 {
 public:
-    Lock(Mutex<SingleProcess> &mutex) : lock(mutex.mutex)
+    Lock(Mutex<SingleProcess> &mutex)
+        : lock(mutex.protocol_mutex
+                   ? std::unique_lock<std::mutex>()
+                   : std::unique_lock<std::mutex>(mutex.mutex)),
+          protocol_lock(mutex.protocol_mutex
+                            ? std::unique_lock<PthreadMutex>(
+                                  *mutex.protocol_mutex)
+                            : std::unique_lock<PthreadMutex>())
     {
     }
+    // (only one of them owns its mutex, see Mutex<SingleProcess>)
     std::unique_lock<std::mutex> lock;
+    std::unique_lock<PthreadMutex> protocol_lock;
 };
 
 template <>
@@ -74,6 +212,55 @@ public:
     shared_memory::Lock lock;
 };
 
+template <>
+class Lock<MultiProcessesSingleSegment>
+{
+public:
+    Lock(Mutex<MultiProcessesSingleSegment> &mutex)
+        : mutex(mutex.mutex), segment(mutex.segment.get())
+    {
+        check(pthread_mutex_lock(this->mutex));
+    }
+    ~Lock()
+    {
+        pthread_mutex_unlock(mutex);
+    }
+    Lock(const Lock &) = delete;
+    Lock &operator=(const Lock &) = delete;
+    // the previous owner of the (robust) mutex died while holding it
+    void recover()
+    {
+        segment->recover();
+        pthread_mutex_consistent(mutex);
+    }
+    // r: returned by a function acquiring the mutex. Recovers if its
+    // previous owner died, throws std::runtime_error if it was not
+    // acquired (e.g. ENOTRECOVERABLE: a process acquired it with
+    // EOWNERDEAD, then released it without restoring its consistency)
+    void check(int r)
+    {
+        if (r == EOWNERDEAD)
+        {
+            recover();
+        }
+        else if (r != 0)
+        {
+            throw std::runtime_error("time series mutex: " +
+                                     std::string(std::strerror(r)));
+        }
+    }
+    pthread_mutex_t *mutex;
+    Segment *segment;
+};
+
+template <>
+class Lock<MultiProcessesPayloadArena>
+    : public Lock<MultiProcessesSingleSegment>
+{
+public:
+    using Lock<MultiProcessesSingleSegment>::Lock;
+};
+
 // ------- Condition variable ------- //
 
 template <typename P>
@@ -81,38 +268,97 @@ class ConditionVariable
 {
 };
 
+// The condition variables keep track of the number of threads (or processes)
+// currently blocked in wait / wait_for. The counter is only read and written
+// while the time series mutex is held, so a writer checking has_waiters()
+// under the lock (and notifying after releasing it) can not miss a waiter:
+// a waiter increments the counter and enters the wait without releasing
+// the mutex in between.
+
 template <>
 class ConditionVariable<SingleProcess>
 {
 public:
+    // lock_protocol: of the corresponding Mutex<SingleProcess>
+    ConditionVariable(LockProtocol lock_protocol = LockProtocol::DEFAULT)
+        : waiters_(0)
+    {
+        if (lock_protocol != LockProtocol::DEFAULT)
+        {
+            protocol_condition.reset(new std::condition_variable_any);
+        }
+    }
     ~ConditionVariable()
     {
-        condition.notify_all();
+        notify_all();
     }
     void notify_all()
     {
-        condition.notify_all();
+        if (protocol_condition)
+        {
+            protocol_condition->notify_all();
+        }
+        else
+        {
+            condition.notify_all();
+        }
+    }
+    // to be called with the lock held
+    bool has_waiters() const
+    {
+        return waiters_ > 0;
     }
     void wait(Lock<SingleProcess> &lock)
     {
-        condition.wait(lock.lock);
+        waiters_++;
+        if (protocol_condition)
+        {
+            protocol_condition->wait(lock.protocol_lock);
+        }
+        else
+        {
+            condition.wait(lock.lock);
+        }
+        waiters_--;
     }
     bool wait_for(Lock<SingleProcess> &lock, double max_duration_s)
     {
         std::chrono::duration<double> chrono_duration(max_duration_s);
-        std::cv_status status = condition.wait_for(lock.lock, chrono_duration);
+        waiters_++;
+        std::cv_status status =
+            protocol_condition
+                ? protocol_condition->wait_for(lock.protocol_lock,
+                                               chrono_duration)
+                : condition.wait_for(lock.lock, chrono_duration);
+        waiters_--;
         return !(status == std::cv_status::timeout);
     }
     std::condition_variable condition;
+    // waiting on the PthreadMutex of the other protocols (nullptr by
+    // default, see Mutex<SingleProcess>)
+    std::unique_ptr<std::condition_variable_any> protocol_condition;
+
+private:
+    long waiters_;
 };
 
+// the number of waiters is shared by all processes, and is
+// stored in the shared memory segment object_id + shm_waiters
+static const std::string shm_waiters("_waiters");
+
 template <>
 class ConditionVariable<MultiProcesses>
 {
 public:
     ConditionVariable(std::string object_id, bool clear_on_destruction)
-        : condition(object_id, clear_on_destruction)
+        : condition(object_id, clear_on_destruction),
+          waiters_(object_id + shm_waiters, 1, clear_on_destruction, false)
     {
+        if (clear_on_destruction)
+        {
+            // leader: (re)initializing the counter
+            waiters_.set(0, 0);
+        }
     }
     ~ConditionVariable()
     {
@@ -122,16 +368,109 @@ public:
     {
         condition.notify_all();
     }
+    // to be called with the lock held. Note that a process
+    // crashing while waiting leaves the counter incremented, which
+    // only results in unnecessary (but harmless) notifications.
+    bool has_waiters()
+    {
+        long waiters;
+        waiters_.get(0, waiters);
+        return waiters > 0;
+    }
     void wait(Lock<MultiProcesses> &lock)
     {
+        add_waiters(1);
         condition.wait(lock.lock);
+        add_waiters(-1);
     }
     bool wait_for(Lock<MultiProcesses> &lock, double max_duration_s)
     {
         long wait_time = static_cast<long>(max_duration_s * 1e6);
-        return condition.timed_wait(lock.lock, wait_time);
+        add_waiters(1);
+        bool notified = condition.timed_wait(lock.lock, wait_time);
+        add_waiters(-1);
+        return notified;
     }
     shared_memory::ConditionVariable condition;
+
+private:
+    void add_waiters(long value)
+    {
+        long waiters;
+        waiters_.get(0, waiters);
+        waiters_.set(0, waiters + value);
+    }
+    shared_memory::array<long> waiters_;
+};
+
+template <>
+class ConditionVariable<MultiProcessesSingleSegment>
+{
+public:
+    ConditionVariable(std::shared_ptr<Segment> segment)
+        : segment_(segment),
+          condition_(&segment->header()->condition),
+          waiters_(&segment->header()->waiters)
+    {
+    }
+    ~ConditionVariable()
+    {
+        notify_all();
+    }
+    void notify_all()
+    {
+        pthread_cond_broadcast(condition_);
+    }
+    // to be called with the lock held
+    bool has_waiters() const
+    {
+        return *waiters_ > 0;
+    }
+    void wait(Lock<MultiProcessesSingleSegment> &lock)
+    {
+        (*waiters_)++;
+        int r = pthread_cond_wait(condition_, lock.mutex);
+        (*waiters_)--;
+        lock.check(r);
+    }
+    bool wait_for(Lock<MultiProcessesSingleSegment> &lock,
+                  double max_duration_s)
+    {
+        // the condition variable uses the monotonic clock
+        // (see Segment::create)
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        long nanoseconds = static_cast<long>(max_duration_s * 1e9);
+        deadline.tv_sec += nanoseconds / 1000000000L;
+        deadline.tv_nsec += nanoseconds % 1000000000L;
+        if (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        (*waiters_)++;
+        int r = pthread_cond_timedwait(condition_, lock.mutex, &deadline);
+        (*waiters_)--;
+        if (r == ETIMEDOUT)
+        {
+            return false;
+        }
+        lock.check(r);
+        return true;
+    }
+
+private:
+    std::shared_ptr<Segment> segment_;
+    pthread_cond_t *condition_;
+    long *waiters_;
+};
+
+template <>
+class ConditionVariable<MultiProcessesPayloadArena>
+    : public ConditionVariable<MultiProcessesSingleSegment>
+{
+public:
+    using ConditionVariable<MultiProcessesSingleSegment>::ConditionVariable;
 };
 
 // -------- items containers -------- //
@@ -142,13 +481,29 @@ class Vector
 };
 
 // single process
+// (storage aligned on cache lines, see aligned_allocator.hpp)
 
 template <typename T>
 class Vector<SingleProcess, T>
 {
 public:
-    Vector(std::size_t size) : v_(size)
+    Vector(std::size_t size,
+           PageBacking page_backing = PageBacking::DEFAULT_PAGES,
+           MemoryCommit commit = MemoryCommit::DEFAULT)
+        : v_(size, AlignedAllocator<T>(page_backing, commit))
+    {
+    }
+    PageBacking page_backing() const
     {
+        return v_.get_allocator().obtained().page_backing;
+    }
+    MemoryCommit memory_commit() const
+    {
+        return v_.get_allocator().obtained().commit;
+    }
+    std::size_t resident_memory() const
+    {
+        return internal::resident_memory(v_.data(), v_.size() * sizeof(T));
     }
     std::size_t size() const
     {
@@ -167,9 +522,13 @@ public:
     {
         v_[index] = t;
     }
+    const T *data() const
+    {
+        return v_.data();
+    }
 
 private:
-    std::vector<T> v_;
+    std::vector<T, AlignedAllocator<T> > v_;
 };
 
 // multi-processes
@@ -181,9 +540,22 @@ public:
     Vector(std::size_t size,
            std::string segment_id,
            bool clear_on_destruction = true)
-        : a_(segment_id, size, clear_on_destruction)
+        : segment_id_(segment_id), a_(segment_id, size, clear_on_destruction)
     {
     }
+    // memory managed by the shared_memory package
+    PageBacking page_backing() const
+    {
+        return PageBacking::DEFAULT_PAGES;
+    }
+    MemoryCommit memory_commit() const
+    {
+        return MemoryCommit::DEFAULT;
+    }
+    std::size_t resident_memory() const
+    {
+        return shared_memory_footprint(segment_id_);
+    }
     std::size_t size() const
     {
         return a_.size();
@@ -202,7 +574,257 @@ public:
     }
 
 private:
+    std::string segment_id_;
     shared_memory::array<T> a_;
 };
+
+// multi-processes, single segment.
+// Elements are stored as selected by their storage method (see
+// element_storage.hpp): raw and flat slots hold the element (or its flat
+// form) in place, serialized slots: | size (std::uint64_t) | serialized data |
+
+template <typename T>
+class Vector<MultiProcessesSingleSegment, T>
+{
+public:
+    static constexpr StorageMethod method = storage_method_v<T>;
+    // element or flat form (raw and flat storage)
+    typedef typename StoredType<T>::type Stored;
+
+    static_assert(method == StorageMethod::SERIALIZED ||
+                      alignof(Stored) <= CACHE_LINE_SIZE,
+                  "time_series: over-aligned elements are not supported");
+
+    // size (in bytes) of each slot of the segment
+    // (the slots start on a cache line, sizeof(Stored) being a multiple
+    // of its alignment, all the slots are aligned)
+    static std::size_t slot_size()
+    {
+        if constexpr (method != StorageMethod::SERIALIZED)
+        {
+            return sizeof(Stored);
+        }
+        else
+        {
+            std::size_t size = sizeof(std::uint64_t) +
+                               shared_memory::Serializer<T>::serializable_size();
+            // keeping the slots 8 bytes aligned
+            return ((size + 7) / 8) * 8;
+        }
+    }
+
+    Vector(std::shared_ptr<Segment> segment, char *slots, std::size_t size)
+        : segment_(segment), slots_(slots), size_(size), slot_size_(slot_size())
+    {
+    }
+    PageBacking page_backing() const
+    {
+        return segment_->page_backing();
+    }
+    MemoryCommit memory_commit() const
+    {
+        return segment_->memory_commit();
+    }
+    std::size_t resident_memory() const
+    {
+        return internal::resident_memory(slots_, size_ * slot_size_);
+    }
+    std::size_t size() const
+    {
+        return size_;
+    }
+    // element (raw) or flat form (flat) stored in the slot
+    const Stored &view(int index) const
+    {
+        static_assert(method != StorageMethod::SERIALIZED,
+                      "time_series: serialized elements can not be viewed");
+        return *std::launder(
+            reinterpret_cast<const Stored *>(slots_ + index * slot_size_));
+    }
+    void get(int index, T &t)
+    {
+        if constexpr (method == StorageMethod::RAW)
+        {
+            std::memcpy(&t, slots_ + index * slot_size_, sizeof(T));
+        }
+        else if constexpr (method == StorageMethod::FLAT)
+        {
+            FlatForm<T>::from_flat(view(index), t);
+        }
+        else
+        {
+            serializer_.deserialize(get_serialized(index), t);
+        }
+    }
+    std::string get_serialized(int index)
+    {
+        if constexpr (method != StorageMethod::SERIALIZED)
+        {
+            throw std::logic_error("get_serialized: elements stored " +
+                                   to_string(method) +
+                                   " are not serialized");
+        }
+        else
+        {
+            const char *slot = slots_ + index * slot_size_;
+            std::uint64_t size;
+            std::memcpy(&size, slot, sizeof(size));
+            return std::string(slot + sizeof(size), size);
+        }
+    }
+    void set(int index, const T &t)
+    {
+        char *slot = slots_ + index * slot_size_;
+        if constexpr (method == StorageMethod::RAW)
+        {
+            std::memcpy(slot, &t, sizeof(T));
+        }
+        else if constexpr (method == StorageMethod::FLAT)
+        {
+            FlatForm<T>::to_flat(t, *new (slot) Stored);
+        }
+        else
+        {
+            const std::string &serialized = serializer_.serialize(t);
+            std::uint64_t size = serialized.size();
+            if (sizeof(size) + size > slot_size_)
+            {
+                throw std::runtime_error(
+                    "time_series: serialized element larger than its slot");
+            }
+            std::memcpy(slot, &size, sizeof(size));
+            std::memcpy(slot + sizeof(size), serialized.data(), size);
+        }
+    }
+
+private:
+    std::shared_ptr<Segment> segment_;
+    char *slots_;
+    std::size_t size_;
+    std::size_t slot_size_;
+    // (raw and flat elements do not need to be serializable)
+    std::conditional_t<method == StorageMethod::SERIALIZED,
+                       shared_memory::Serializer<T>,
+                       char>
+        serializer_;
+};
+
+// multi-processes, payload arena: the timestamps are stored as for the
+// single segment layout ...
+
+template <typename T>
+class Vector<MultiProcessesPayloadArena, T>
+    : public Vector<MultiProcessesSingleSegment, T>
+{
+public:
+    using Vector<MultiProcessesSingleSegment, T>::Vector;
+};
+
+// ... while the payloads (bytes) are stored one after the other in a
+// ring buffer (the arena), each slot storing the position and length
+// of its payload. Positions are absolute (i.e. the number of bytes written
+// in the arena before the payload), so that a payload position older than
+// the arena size indicates it has been overwritten.
+// A payload is never split: if it does not fit before the end of the
+// arena, it is written at its beginning.
+
+template <>
+class Vector<MultiProcessesPayloadArena, std::string>
+{
+public:
+    struct Slot
+    {
+        std::uint64_t position;
+        std::uint64_t length;
+    };
+
+    static std::size_t slot_size()
+    {
+        return sizeof(Slot);
+    }
+
+    Vector(std::shared_ptr<Segment> segment, char *slots, std::size_t size)
+        : segment_(segment),
+          slots_(reinterpret_cast<Slot *>(slots)),
+          size_(size),
+          arena_(segment->arena()),
+          arena_size_(segment->header()->arena_size),
+          head_(&segment->header()->arena_head)
+    {
+    }
+    PageBacking page_backing() const
+    {
+        return segment_->page_backing();
+    }
+    MemoryCommit memory_commit() const
+    {
+        return segment_->memory_commit();
+    }
+    std::size_t resident_memory() const
+    {
+        return internal::resident_memory(slots_, size_ * sizeof(Slot)) +
+               internal::resident_memory(arena_, arena_size_);
+    }
+    std::size_t size() const
+    {
+        return size_;
+    }
+    std::size_t arena_size() const
+    {
+        return arena_size_;
+    }
+    // position at which a payload of this length will be written
+    std::uint64_t next_position(std::size_t length) const
+    {
+        std::uint64_t position = *head_;
+        if (position % arena_size_ + length > arena_size_)
+        {
+            position += arena_size_ - position % arena_size_;
+        }
+        return position;
+    }
+    // position of the payload stored in the slot
+    std::uint64_t payload_position(int index) const
+    {
+        return slots_[index].position;
+    }
+    std::string_view view(int index) const
+    {
+        const Slot &slot = slots_[index];
+        return std::string_view(arena_ + slot.position % arena_size_,
+                                slot.length);
+    }
+    void get(int index, std::string &payload)
+    {
+        payload.assign(view(index));
+    }
+    std::string get_serialized(int index)
+    {
+        return std::string(view(index));
+    }
+    void set(int index, const std::string &payload)
+    {
+        if (payload.size() > arena_size_)
+        {
+            throw std::invalid_argument(
+                "time_series: payload of " + std::to_string(payload.size()) +
+                " bytes larger than the arena (" +
+                std::to_string(arena_size_) + " bytes)");
+        }
+        std::uint64_t position = next_position(payload.size());
+        std::memcpy(
+            arena_ + position % arena_size_, payload.data(), payload.size());
+        slots_[index] = Slot{position, payload.size()};
+        *head_ = position + payload.size();
+    }
+
+private:
+    std::shared_ptr<Segment> segment_;
+    Slot *slots_;
+    std::size_t size_;
+    char *arena_;
+    std::size_t arena_size_;
+    std::uint64_t *head_;
+};
 }  // namespace internal
 }  // namespace time_series
@@ -0,0 +1,250 @@
+// Copyright (c) 2019 Max Planck Gesellschaft
+// Vincent Berenz
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "time_series/interface.hpp"
+
+namespace time_series
+{
+namespace internal
+{
+// type erased subscriber, see Subscription
+class SubscriberBase
+{
+public:
+    virtual ~SubscriberBase()
+    {
+    }
+    virtual void cancel() = 0;
+    virtual bool cancelled() const = 0;
+    virtual std::size_t delivered() const = 0;
+    virtual std::size_t dropped() const = 0;
+    virtual std::size_t backlog() const = 0;
+};
+
+// Subscription of a callback (see TimeSeries::subscribe).
+// push queues samples in a bounded backlog (dropping the oldest ones if
+// full) and posts a drain task to the executor if none is pending.
+// At most one drain task is pending or running at a time, so the callback
+// is never called concurrently, and samples are delivered in order.
+// A drain task discarded by the executor without being run (e.g. by a
+// stopping WorkerPool) is no longer pending: the next push posts another.
+template <typename T>
+class Subscriber : public SubscriberBase,
+                   public std::enable_shared_from_this<Subscriber<T>>
+{
+public:
+    typedef std::function<void(const std::vector<Sample<T>> &)> Callback;
+    typedef std::function<void(std::function<void()>)> Executor;
+
+    Subscriber(Callback callback, Executor executor, std::size_t max_backlog)
+        : callback_(std::move(callback)),
+          executor_(std::move(executor)),
+          max_backlog_(max_backlog),
+          scheduled_(false),
+          running_(false),
+          cancelled_(false),
+          delivered_(0),
+          dropped_(0)
+    {
+    }
+
+    void push(const Sample<T> &sample)
+    {
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            if (cancelled_)
+            {
+                return;
+            }
+            if (backlog_.size() >= max_backlog_)
+            {
+                backlog_.pop_front();
+                dropped_++;
+            }
+            backlog_.push_back(sample);
+            if (scheduled_)
+            {
+                return;
+            }
+            scheduled_ = true;
+        }
+        schedule();
+    }
+
+    void cancel()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cancelled_ = true;
+        backlog_.clear();
+        // (pending drain tasks return without calling the callback)
+        idle_.wait(lock, [this]() { return !running_; });
+    }
+
+    bool cancelled() const
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return cancelled_;
+    }
+
+    std::size_t delivered() const
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return delivered_;
+    }
+
+    std::size_t dropped() const
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return dropped_;
+    }
+
+    std::size_t backlog() const
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return backlog_.size();
+    }
+
+private:
+    // state shared by the copies of a posted drain task: the last copy
+    // destroyed without the task having run clears scheduled_
+    struct PendingDrain
+    {
+        ~PendingDrain()
+        {
+            if (!run)
+            {
+                subscriber->discarded();
+            }
+        }
+        std::shared_ptr<Subscriber<T>> subscriber;
+        bool run = false;
+    };
+
+    void schedule()
+    {
+        std::shared_ptr<PendingDrain> pending =
+            std::make_shared<PendingDrain>();
+        pending->subscriber = this->shared_from_this();
+        executor_([pending]() {
+            pending->run = true;
+            pending->subscriber->drain();
+        });
+    }
+
+    void discarded()
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        scheduled_ = false;
+    }
+
+    // delivers the current backlog as a single batch, then posts another
+    // drain task if more samples arrived meanwhile (rather than looping,
+    // so that a busy subscriber does not monopolize a worker)
+    void drain()
+    {
+        std::vector<Sample<T>> batch;
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            if (cancelled_ || backlog_.empty())
+            {
+                scheduled_ = false;
+                return;
+            }
+            batch.assign(backlog_.begin(), backlog_.end());
+            backlog_.clear();
+            running_ = true;
+        }
+        callback_(batch);
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            running_ = false;
+            delivered_ += batch.size();
+            idle_.notify_all();
+            if (cancelled_ || backlog_.empty())
+            {
+                scheduled_ = false;
+                return;
+            }
+        }
+        schedule();
+    }
+
+    Callback callback_;
+    Executor executor_;
+    std::size_t max_backlog_;
+    mutable std::mutex mutex_;
+    std::condition_variable idle_;
+    std::deque<Sample<T>> backlog_;
+    bool scheduled_;
+    bool running_;
+    bool cancelled_;
+    std::size_t delivered_;
+    std::size_t dropped_;
+};
+
+// subscribers of a time series. append reads only an atomic counter when
+// there are none.
+template <typename T>
+class Subscribers
+{
+public:
+    Subscribers() : size_(0)
+    {
+    }
+
+    std::size_t size() const
+    {
+        return size_.load(std::memory_order_acquire);
+    }
+
+    void add(std::shared_ptr<Subscriber<T>> subscriber)
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        subscribers_.push_back(std::move(subscriber));
+        size_.store(subscribers_.size(), std::memory_order_release);
+    }
+
+    // serializes the appends (and therefore the pushes) while there are
+    // subscribers, so that samples are pushed in order of their index
+    std::mutex &mutex()
+    {
+        return mutex_;
+    }
+
+    // (mutex() should be locked)
+    void publish(const Sample<T> &sample)
+    {
+        subscribers_.erase(
+            std::remove_if(subscribers_.begin(),
+                           subscribers_.end(),
+                           [](const std::shared_ptr<Subscriber<T>> &s) {
+                               return s->cancelled();
+                           }),
+            subscribers_.end());
+        size_.store(subscribers_.size(), std::memory_order_release);
+        for (const std::shared_ptr<Subscriber<T>> &subscriber : subscribers_)
+        {
+            subscriber->push(sample);
+        }
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<std::shared_ptr<Subscriber<T>>> subscribers_;
+    std::atomic<std::size_t> size_;
+};
+
+}  // namespace internal
+}  // namespace time_series
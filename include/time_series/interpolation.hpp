@@ -0,0 +1,154 @@
+/**
+ * @file interpolation.hpp
+ * license License BSD-3-Clause
+ * @copyright Copyright (c) 2019, Max Planck Gesellschaft.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace time_series
+{
+/**
+ * How value_at_time computes an element between two elements a and b
+ * of timestamps t_a <= t < t_b (alpha = (t - t_a) / (t_b - t_a)):
+ */
+enum class Interpolation
+{
+    //! a (any element type)
+    ZERO_ORDER_HOLD,
+    //! a + (b - a) * alpha (arithmetic types and Eigen matrices of
+    //! floating point scalars). Integers are interpolated exactly (in
+    //! integer arithmetic), rounded to the nearest (ties upward).
+    LINEAR,
+    //! a.slerp(alpha, b) (Eigen quaternions)
+    SLERP
+};
+
+namespace internal
+{
+template <typename T, typename = void>
+struct InterpolationScalar
+{
+    typedef double type;
+};
+
+// (Eigen types: interpolation in their own scalar type)
+template <typename T>
+struct InterpolationScalar<T, std::void_t<typename T::Scalar>>
+{
+    typedef typename T::Scalar type;
+};
+
+// (not for integral scalars, e.g. Eigen matrices of integers: alpha
+// would be truncated to 0)
+template <typename T, typename = void>
+struct SupportsLinear : std::false_type
+{
+};
+
+template <typename T>
+struct SupportsLinear<
+    T,
+    std::void_t<decltype(T(std::declval<const T&>() +
+                           (std::declval<const T&>() -
+                            std::declval<const T&>()) *
+                               std::declval<typename InterpolationScalar<
+                                   T>::type>()))>>
+    : std::bool_constant<!std::is_integral<
+          typename InterpolationScalar<T>::type>::value>
+{
+};
+
+// a + (b - a) * alpha for integers, in (128 bits) integer arithmetic:
+// exact over the whole range of T (no conversion to double), alpha being
+// taken as a fraction of 2^53 (the precision of a double in [0, 1))
+template <typename T>
+T interpolate_integral(T a, T b, double alpha)
+{
+    static_assert(sizeof(T) <= sizeof(std::uint64_t),
+                  "interpolation: integers of at most 64 bits");
+    if constexpr (std::is_same<T, bool>::value)
+    {
+        return alpha < 0.5 ? a : b;
+    }
+    else
+    {
+        typedef std::make_unsigned_t<T> U;
+        __extension__ typedef unsigned __int128 Wide;
+        constexpr int BITS = 53;
+        std::uint64_t numerator =
+            static_cast<std::uint64_t>(std::ldexp(alpha, BITS));
+        // (modulo arithmetic: |b - a| fits U, also for signed T)
+        bool increasing = b >= a;
+        U distance = increasing ? static_cast<U>(static_cast<U>(b) -
+                                                 static_cast<U>(a))
+                                : static_cast<U>(static_cast<U>(a) -
+                                                 static_cast<U>(b));
+        Wide product = static_cast<Wide>(distance) * numerator;
+        // rounded to the nearest value, ties upward
+        Wide half = Wide(1) << (BITS - 1);
+        U offset = static_cast<U>(
+            (increasing ? product + half : product + half - 1) >> BITS);
+        return static_cast<T>(increasing ? static_cast<U>(a) + offset
+                                         : static_cast<U>(a) - offset);
+    }
+}
+
+template <typename T, typename = void>
+struct SupportsSlerp : std::false_type
+{
+};
+
+template <typename T>
+struct SupportsSlerp<
+    T,
+    std::void_t<decltype(T(std::declval<const T&>().slerp(
+        std::declval<typename InterpolationScalar<T>::type>(),
+        std::declval<const T&>())))>> : std::true_type
+{
+};
+
+// element between a and b (alpha in [0, 1))
+// throws std::invalid_argument if the method is not supported by T
+template <typename T>
+T interpolate(const T& a, const T& b, double alpha, Interpolation method)
+{
+    typedef typename InterpolationScalar<T>::type Scalar;
+    switch (method)
+    {
+        case Interpolation::ZERO_ORDER_HOLD:
+            return a;
+        case Interpolation::LINEAR:
+            if constexpr (std::is_integral<T>::value)
+            {
+                return interpolate_integral(a, b, alpha);
+            }
+            else if constexpr (std::is_arithmetic<T>::value)
+            {
+                return static_cast<T>(a + (b - a) * alpha);
+            }
+            else if constexpr (SupportsLinear<T>::value)
+            {
+                return T(a + (b - a) * static_cast<Scalar>(alpha));
+            }
+            break;
+        case Interpolation::SLERP:
+            if constexpr (SupportsSlerp<T>::value)
+            {
+                return T(a.slerp(static_cast<Scalar>(alpha), b));
+            }
+            break;
+    }
+    throw std::invalid_argument(
+        "value_at_time: interpolation method not supported by the "
+        "element type");
+}
+
+}  // namespace internal
+}  // namespace time_series
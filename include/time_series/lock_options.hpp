@@ -0,0 +1,42 @@
+/**
+ * @file lock_options.hpp
+ * license License BSD-3-Clause
+ * @copyright Copyright (c) 2019, Max Planck Gesellschaft.
+ */
+
+#pragma once
+
+#include <string>
+
+namespace time_series
+{
+/**
+ * Protocol of the mutex of a time series.
+ * - DEFAULT: the thread holding the mutex keeps its own priority.
+ * - PRIORITY_INHERITANCE: PTHREAD_PRIO_INHERIT mutex, i.e. the thread
+ *   holding the mutex runs (at least) at the priority of the highest
+ *   priority thread waiting for it. This bounds the time a real time
+ *   (e.g. SCHED_FIFO) thread may wait for a lower priority thread using
+ *   the same time series (priority inversion), at the cost of slower
+ *   (kernel arbitrated) contended locking. For multiprocesses time series,
+ *   the protocol is selected by the leader, and only supported by the
+ *   SingleSegment layout.
+ */
+enum class LockProtocol
+{
+    DEFAULT,
+    PRIORITY_INHERITANCE
+};
+
+inline std::string to_string(LockProtocol lock_protocol)
+{
+    switch (lock_protocol)
+    {
+        case LockProtocol::PRIORITY_INHERITANCE:
+            return "priority inheritance";
+        default:
+            return "default";
+    }
+}
+
+}  // namespace time_series
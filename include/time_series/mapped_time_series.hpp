@@ -0,0 +1,207 @@
+/**
+ * @file mapped_time_series.hpp
+ * license License BSD-3-Clause
+ * @copyright Copyright (c) 2019, Max Planck Gesellschaft.
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "time_series/interface.hpp"
+
+namespace time_series
+{
+/**
+ * @brief Read only view of a time series, which elements are computed
+ * from the elements of the source time series (e.g. the norm of a force,
+ * or a joint of a robot state), without copying them into another time
+ * series.
+ *
+ * Indexes, timestamps and waits are those of the source. The function
+ * is applied only when an element is read. If memoize is true, the result
+ * of the last element read is kept, so that reading it again (e.g. by
+ * calls to newest_element() with no new element) does not apply the
+ * function again.
+ *
+ * The source may be any time series (including another view), and should
+ * outlive the view. Tags are specific to the view. Elements filtered out
+ * of the source can be represented by mapping to std::optional.
+ */
+template <typename U, typename T>
+class MappedTimeSeries : public TimeSeriesInterface<U>
+{
+public:
+    typedef std::function<U(const T&)> Function;
+
+    /**
+     * @param source the source time series
+     * @param function computes an element of the view from the element
+     * of the source of the same index. Should be a pure function (it may
+     * be called concurrently by readers, and its results are memoized).
+     * @param memoize if true, the result of the last element read is kept
+     */
+    MappedTimeSeries(const TimeSeriesInterface<T>& source,
+                     Function function,
+                     bool memoize = true)
+        : source_(source),
+          function_(std::move(function)),
+          memoize_(memoize),
+          tagged_timeindex_(source.newest_timeindex(false)),
+          memo_index_(EMPTY)
+    {
+    }
+
+    Index newest_timeindex(bool wait = true) const
+    {
+        return source_.newest_timeindex(wait);
+    }
+
+    Index count_appended_elements() const
+    {
+        return source_.count_appended_elements();
+    }
+
+    Index oldest_timeindex(bool wait = true) const
+    {
+        return source_.oldest_timeindex(wait);
+    }
+
+    U newest_element() const
+    {
+        while (true)
+        {
+            Index newest = source_.newest_timeindex();
+            try
+            {
+                return (*this)[newest];
+            }
+            catch (const std::invalid_argument&)
+            {
+                // dropped meanwhile (source of max length 1): retrying
+                // with the new newest element
+            }
+        }
+    }
+
+    /**
+     * @brief applies the function to the element of the source (or
+     * returns the memoized result). Waits if the element is not yet in the
+     * source.
+     * @throws std::invalid_argument if the element is older than the
+     * oldest element of the source.
+     */
+    U operator[](const Index& timeindex) const
+    {
+        if (memoize_)
+        {
+            std::lock_guard<std::mutex> guard(memo_mutex_);
+            if (memo_index_ == timeindex && memo_)
+            {
+                return *memo_;
+            }
+        }
+        U u = function_(source_[timeindex]);
+        if (memoize_)
+        {
+            std::lock_guard<std::mutex> guard(memo_mutex_);
+            if (timeindex >= memo_index_)
+            {
+                memo_index_ = timeindex;
+                memo_ = std::make_unique<U>(u);
+            }
+        }
+        return u;
+    }
+
+    Timestamp timestamp_ms(const Index& timeindex) const
+    {
+        return source_.timestamp_ms(timeindex);
+    }
+
+    Timestamp timestamp_s(const Index& timeindex) const
+    {
+        return source_.timestamp_s(timeindex);
+    }
+
+    bool wait_for_timeindex(const Index& timeindex,
+                            const double& max_duration_s =
+                                std::numeric_limits<double>::quiet_NaN()) const
+    {
+        return source_.wait_for_timeindex(timeindex, max_duration_s);
+    }
+
+    std::size_t length() const
+    {
+        return source_.length();
+    }
+
+    std::size_t max_length() const
+    {
+        return source_.max_length();
+    }
+
+    bool has_changed_since_tag() const
+    {
+        std::lock_guard<std::mutex> guard(tag_mutex_);
+        return tagged_timeindex_ != source_.newest_timeindex(false);
+    }
+
+    void tag(const Index& timeindex)
+    {
+        std::lock_guard<std::mutex> guard(tag_mutex_);
+        tagged_timeindex_ = timeindex;
+    }
+
+    Index tagged_timeindex() const
+    {
+        std::lock_guard<std::mutex> guard(tag_mutex_);
+        return tagged_timeindex_;
+    }
+
+    //! @throws std::logic_error (views are read only)
+    void append(const U&)
+    {
+        throw std::logic_error(
+            "MappedTimeSeries: can not append to a view, append to the "
+            "source instead");
+    }
+
+    bool is_empty() const
+    {
+        return source_.is_empty();
+    }
+
+private:
+    const TimeSeriesInterface<T>& source_;
+    Function function_;
+    bool memoize_;
+    mutable std::mutex tag_mutex_;
+    Index tagged_timeindex_;
+    mutable std::mutex memo_mutex_;
+    mutable Index memo_index_;
+    // (pointer: U is not required to be default constructible)
+    mutable std::unique_ptr<U> memo_;
+};
+
+/**
+ * @brief returns a MappedTimeSeries view of source, U being the return
+ * type of function
+ */
+template <typename T, typename F>
+MappedTimeSeries<typename std::decay<decltype(
+                     std::declval<F>()(std::declval<const T&>()))>::type,
+                 T>
+map_view(const TimeSeriesInterface<T>& source, F function, bool memoize = true)
+{
+    typedef typename std::decay<decltype(
+        std::declval<F>()(std::declval<const T&>()))>::type U;
+    return MappedTimeSeries<U, T>(source, std::move(function), memoize);
+}
+
+}  // namespace time_series
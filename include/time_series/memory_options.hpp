@@ -0,0 +1,93 @@
+/**
+ * @file memory_options.hpp
+ * license License BSD-3-Clause
+ * @copyright Copyright (c) 2019, Max Planck Gesellschaft.
+ */
+
+#pragma once
+
+#include <string>
+
+namespace time_series
+{
+/**
+ * Pages backing the memory of a time series.
+ * - DEFAULT_PAGES: regular (4 KB) pages.
+ * - TRANSPARENT_HUGE_PAGES: the memory is 2 MB aligned and advised for
+ *   transparent huge pages (madvise(MADV_HUGEPAGE)). Whether huge pages
+ *   are actually used depends on the kernel configuration
+ *   (/sys/kernel/mm/transparent_hugepage/enabled for single process time
+ *   series, .../shmem_enabled for multiprocesses time series).
+ * - HUGE_PAGES: the memory is backed by (reserved) 2 MB huge pages:
+ *   MAP_HUGETLB for single process time series, a file on the hugetlbfs
+ *   mount point for multiprocesses time series.
+ *
+ * When HUGE_PAGES is requested, TRANSPARENT_HUGE_PAGES is used
+ * if no huge page is available, and DEFAULT_PAGES if transparent huge pages
+ * are not supported. The page_backing() method of the time series
+ * returns the backing that was actually obtained.
+ */
+enum class PageBacking
+{
+    DEFAULT_PAGES,
+    TRANSPARENT_HUGE_PAGES,
+    HUGE_PAGES
+};
+
+inline std::string to_string(PageBacking page_backing)
+{
+    switch (page_backing)
+    {
+        case PageBacking::TRANSPARENT_HUGE_PAGES:
+            return "transparent huge pages";
+        case PageBacking::HUGE_PAGES:
+            return "huge pages";
+        default:
+            return "default pages";
+    }
+}
+
+/**
+ * When the memory of a time series is committed.
+ * - DEFAULT: single process time series initialize (and so commit) all their
+ *   elements at construction, multiprocesses time series commit the shared
+ *   memory lazily.
+ * - PREFAULT: all the pages are faulted in at construction (so no page fault
+ *   occur after construction, unless the memory gets swapped out).
+ * - LOCK: as PREFAULT, and the memory is locked (mlock), so that it never
+ *   gets swapped out. Falls back to PREFAULT if the memory can not be locked
+ *   (see RLIMIT_MEMLOCK).
+ * - LAZY: the pages are committed only when first written, for fast
+ *   construction and a low resident footprint of large, rarely filled,
+ *   time series. Elements of single process time series are default
+ *   (rather than value) initialized.
+ *
+ * For multiprocesses time series, PREFAULT and LOCK apply to the mapping of
+ * the process (i.e. followers running real time loops should also request
+ * it). The memory_commit() method of the time series returns
+ * the commit mode that was actually obtained.
+ */
+enum class MemoryCommit
+{
+    DEFAULT,
+    PREFAULT,
+    LOCK,
+    LAZY
+};
+
+inline std::string to_string(MemoryCommit memory_commit)
+{
+    switch (memory_commit)
+    {
+        case MemoryCommit::PREFAULT:
+            return "prefault";
+        case MemoryCommit::LOCK:
+            return "lock";
+        case MemoryCommit::LAZY:
+            return "lazy";
+        default:
+            return "default";
+    }
+}
+
+}  // namespace time_series
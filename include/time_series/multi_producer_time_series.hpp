@@ -0,0 +1,427 @@
+/**
+ * @file multi_producer_time_series.hpp
+ * license License BSD-3-Clause
+ * @copyright Copyright (c) 2019, Max Planck Gesellschaft.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "signal_handler/exceptions.hpp"
+#include "signal_handler/signal_handler.hpp"
+
+#include "real_time_tools/timer.hpp"
+
+#include "time_series/interface.hpp"
+#include "time_series/internal/aligned_allocator.hpp"
+
+namespace time_series
+{
+/**
+ * @brief Threadsafe time series supporting concurrent producers without
+ * locking.
+ *
+ * A producer reserves the index of its element with an atomic
+ * increment, writes the element in the corresponding slot, and publishes
+ * the slot. Slots may be published out of order, but readers only observe
+ * the contiguous prefix of published elements (i.e. newest_timeindex()
+ * returns the highest index for which all elements up to it are published).
+ * append never locks a mutex, except for notifying readers which are
+ * blocked waiting for an element (if any).
+ *
+ * Readers copy the elements without locking (each slot is protected by a
+ * sequence lock), hence the requirement for T to be trivially copyable.
+ * An element which gets overwritten while being read is reported as too old
+ * (std::invalid_argument), as would be an element older than the oldest
+ * element of the time series.
+ *
+ * Elements appended by a same producer are stored in order.
+ */
+template <typename T = int>
+class MultiProducerTimeSeries : public TimeSeriesInterface<T>
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "MultiProducerTimeSeries requires trivially copyable "
+                  "elements");
+
+public:
+    /**
+     * @param max_length max number of elements in the time series
+     * @param start_timeindex time index of the first element
+     * @param throw_on_sigint if true, a signal_handler::ReceivedSignal
+     *     exception is thrown when a SIGINT signal is received while waiting
+     */
+    MultiProducerTimeSeries(size_t max_length,
+                            Index start_timeindex = 0,
+                            bool throw_on_sigint = true)
+        : start_timeindex_(start_timeindex),
+          throw_on_sigint_(throw_on_sigint),
+          slots_(max_length),
+          reserved_(start_timeindex),
+          newest_(start_timeindex - 1),
+          tagged_(start_timeindex - 1),
+          waiters_(0)
+    {
+        if (throw_on_sigint)
+        {
+            signal_handler::SignalHandler::initialize();
+        }
+        // the slot of index i is free for writing once newest_ reached
+        // the element of index i - max_length
+        Index size = static_cast<Index>(max_length);
+        for (Index index = start_timeindex; index < start_timeindex + size;
+             index++)
+        {
+            Slot& slot = slots_[index % size];
+            slot.writing.store(index - size, std::memory_order_relaxed);
+            slot.published.store(index - size, std::memory_order_relaxed);
+        }
+    }
+
+    Index newest_timeindex(bool wait = true) const
+    {
+        Index newest = newest_.load(std::memory_order_acquire);
+        if (newest >= start_timeindex_)
+        {
+            return newest;
+        }
+        if (!wait)
+        {
+            return EMPTY;
+        }
+        wait_for(start_timeindex_, std::numeric_limits<double>::quiet_NaN());
+        return newest_.load(std::memory_order_acquire);
+    }
+
+    Index count_appended_elements() const
+    {
+        return newest_.load(std::memory_order_acquire) - start_timeindex_ + 1;
+    }
+
+    Index oldest_timeindex(bool wait = true) const
+    {
+        Index newest = newest_timeindex(wait);
+        if (newest == EMPTY)
+        {
+            return EMPTY;
+        }
+        return oldest(newest);
+    }
+
+    T newest_element() const
+    {
+        T element;
+        // the newest element may get overwritten while being read
+        // (if max_length producers appended concurrently): retrying
+        // with the new newest element
+        while (!read(newest_timeindex(), &element, nullptr))
+        {
+        }
+        return element;
+    }
+
+    T operator[](const Index& timeindex) const
+    {
+        throw_if_too_old(timeindex);
+        wait_for(timeindex, std::numeric_limits<double>::quiet_NaN());
+        T element;
+        if (!read(timeindex, &element, nullptr))
+        {
+            throw_too_old(timeindex);
+        }
+        return element;
+    }
+
+    Timestamp timestamp_ms(const Index& timeindex) const
+    {
+        throw_if_too_old(timeindex);
+        wait_for(timeindex, std::numeric_limits<double>::quiet_NaN());
+        Timestamp timestamp;
+        if (!read(timeindex, nullptr, &timestamp))
+        {
+            throw_too_old(timeindex);
+        }
+        return timestamp;
+    }
+
+    Timestamp timestamp_s(const Index& timeindex) const
+    {
+        return timestamp_ms(timeindex) / 1000.;
+    }
+
+    bool wait_for_timeindex(const Index& timeindex,
+                            const double& max_duration_s =
+                                std::numeric_limits<double>::quiet_NaN()) const
+    {
+        throw_if_too_old(timeindex);
+        return wait_for(timeindex, max_duration_s);
+    }
+
+    size_t length() const
+    {
+        return std::min(static_cast<size_t>(count_appended_elements()),
+                        max_length());
+    }
+
+    size_t max_length() const
+    {
+        return slots_.size();
+    }
+
+    bool has_changed_since_tag() const
+    {
+        return tagged_.load(std::memory_order_acquire) !=
+               newest_.load(std::memory_order_acquire);
+    }
+
+    void tag(const Index& timeindex)
+    {
+        tagged_.store(timeindex, std::memory_order_release);
+    }
+
+    Index tagged_timeindex() const
+    {
+        return tagged_.load(std::memory_order_acquire);
+    }
+
+    void append(const T& element)
+    {
+        Index size = static_cast<Index>(slots_.size());
+        Index index = reserved_.fetch_add(1, std::memory_order_relaxed);
+        Slot& slot = slots_[index % size];
+
+        // the element previously stored in the slot (one lap before)
+        // may still be written by a slower producer, or not yet be
+        // passed by newest_ (see advance_newest, which would then miss it)
+        while (newest_.load(std::memory_order_acquire) < index - size)
+        {
+            std::this_thread::yield();
+        }
+
+        // sequence lock: readers check 'writing' after copying
+        slot.writing.store(index, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        Timestamp timestamp = real_time_tools::Timer::get_current_time_ms();
+        std::memcpy(&slot.element, &element, sizeof(T));
+        std::memcpy(&slot.timestamp, &timestamp, sizeof(Timestamp));
+        // (sequentially consistent, see advance_newest)
+        slot.published.store(index, std::memory_order_seq_cst);
+
+        advance_newest();
+
+        // see wait_for: readers increment waiters_ before checking newest_,
+        // and hold the mutex until they wait on the condition variable
+        if (waiters_.load(std::memory_order_seq_cst) > 0)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+            }
+            condition_.notify_all();
+        }
+    }
+
+    bool is_empty() const
+    {
+        return count_appended_elements() == 0;
+    }
+
+    /**
+     * @brief returns the newest element, with its index and timestamp,
+     * copied in a single (sequence locked) read. Waits if the time series
+     * is empty.
+     */
+    Sample<T> newest() const
+    {
+        Sample<T> sample;
+        do
+        {
+            sample.index = newest_timeindex();
+        } while (!read(sample.index, &sample.element, &sample.timestamp));
+        return sample;
+    }
+
+    /**
+     * @brief returns the element of the given index, with its timestamp,
+     * copied in a single (sequence locked) read. Waits if the element is
+     * not yet in the time series.
+     * @throws std::invalid_argument if the element is too old.
+     */
+    Sample<T> at(const Index& timeindex) const
+    {
+        throw_if_too_old(timeindex);
+        wait_for(timeindex, std::numeric_limits<double>::quiet_NaN());
+        Sample<T> sample;
+        sample.index = timeindex;
+        if (!read(timeindex, &sample.element, &sample.timestamp))
+        {
+            throw_too_old(timeindex);
+        }
+        return sample;
+    }
+
+private:
+    struct alignas(internal::CACHE_LINE_SIZE) Slot
+    {
+        std::atomic<Index> writing;
+        std::atomic<Index> published;
+        Timestamp timestamp;
+        T element;
+    };
+
+    Index oldest(Index newest) const
+    {
+        return std::max(start_timeindex_,
+                        newest - static_cast<Index>(slots_.size()) + 1);
+    }
+
+    [[noreturn]] void throw_too_old(const Index& timeindex) const
+    {
+        throw std::invalid_argument(
+            "you tried to access time_series element " +
+            std::to_string(timeindex) +
+            " which is too old (oldest in buffer is " +
+            std::to_string(oldest(newest_.load())) + ").");
+    }
+
+    void throw_if_too_old(const Index& timeindex) const
+    {
+        Index newest = newest_.load(std::memory_order_acquire);
+        if (timeindex < start_timeindex_ ||
+            (newest >= start_timeindex_ && timeindex < oldest(newest)))
+        {
+            throw_too_old(timeindex);
+        }
+    }
+
+    // copies the element and/or the timestamp of the (published) index.
+    // Returns false if the slot has been (or is being) overwritten.
+    bool read(Index timeindex, T* element, Timestamp* timestamp) const
+    {
+        const Slot& slot = slots_[timeindex % slots_.size()];
+        if (slot.published.load(std::memory_order_acquire) != timeindex)
+        {
+            return false;
+        }
+        if (element != nullptr)
+        {
+            std::memcpy(element, &slot.element, sizeof(T));
+        }
+        if (timestamp != nullptr)
+        {
+            std::memcpy(timestamp, &slot.timestamp, sizeof(Timestamp));
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.writing.load(std::memory_order_relaxed) == timeindex;
+    }
+
+    // moves newest_ forward over all the contiguous published slots.
+    // Called by all producers after publishing: the published stores and
+    // loads are sequentially consistent, so that of two producers publishing
+    // consecutive indexes concurrently, at least one observes the slot of
+    // the other.
+    void advance_newest()
+    {
+        Index size = static_cast<Index>(slots_.size());
+        Index newest = newest_.load(std::memory_order_seq_cst);
+        while (slots_[(newest + 1) % size].published.load(
+                   std::memory_order_seq_cst) == newest + 1)
+        {
+            // on failure, newest is updated with the current value
+            if (newest_.compare_exchange_weak(
+                    newest, newest + 1, std::memory_order_seq_cst))
+            {
+                newest++;
+            }
+        }
+    }
+
+    // waits until newest_ >= timeindex. Returns false on timeout
+    // (or if SIGINT is received and max_duration_s is not NaN).
+    bool wait_for(Index timeindex, double max_duration_s) const
+    {
+        // duration of each wait, so that SIGINT is checked regularly
+        constexpr double SLICE_S = 0.1;
+
+        if (newest_.load(std::memory_order_acquire) >= timeindex)
+        {
+            return true;
+        }
+        bool timed = std::isfinite(max_duration_s);
+        std::chrono::steady_clock::time_point deadline =
+            std::chrono::steady_clock::now() +
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(timed ? max_duration_s : 0));
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        WaiterCount count(waiters_);
+        while (newest_.load(std::memory_order_seq_cst) < timeindex)
+        {
+            bool sigint = signal_handler::SignalHandler::has_received_sigint();
+            if (timed)
+            {
+                if (sigint || std::chrono::steady_clock::now() >= deadline)
+                {
+                    return false;
+                }
+            }
+            else if (sigint && throw_on_sigint_)
+            {
+                throw signal_handler::ReceivedSignal(SIGINT);
+            }
+            std::chrono::steady_clock::time_point slice_end =
+                std::chrono::steady_clock::now() +
+                std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double>(SLICE_S));
+            condition_.wait_until(
+                lock, timed ? std::min(slice_end, deadline) : slice_end);
+        }
+        return true;
+    }
+
+    // increments the counter for its lifetime
+    class WaiterCount
+    {
+    public:
+        WaiterCount(std::atomic<long>& waiters) : waiters_(waiters)
+        {
+            waiters_.fetch_add(1, std::memory_order_seq_cst);
+        }
+        ~WaiterCount()
+        {
+            waiters_.fetch_sub(1, std::memory_order_seq_cst);
+        }
+
+    private:
+        std::atomic<long>& waiters_;
+    };
+
+    const Index start_timeindex_;
+    const bool throw_on_sigint_;
+
+    std::vector<Slot, internal::AlignedAllocator<Slot>> slots_;
+
+    // reserved_ is written by producers only, newest_ by producers and read
+    // by consumers: on distinct cache lines
+    alignas(internal::CACHE_LINE_SIZE) std::atomic<Index> reserved_;
+    alignas(internal::CACHE_LINE_SIZE) std::atomic<Index> newest_;
+    std::atomic<Index> tagged_;
+
+    alignas(internal::CACHE_LINE_SIZE) mutable std::atomic<long> waiters_;
+    mutable std::mutex mutex_;
+    mutable std::condition_variable condition_;
+};
+
+}  // namespace time_series
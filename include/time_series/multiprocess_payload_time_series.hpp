@@ -0,0 +1,301 @@
+/**
+ * @file multiprocess_payload_time_series.hpp
+ * license License BSD-3-Clause
+ * @copyright Copyright (c) 2019, Max Planck Gesellschaft.
+ */
+
+#pragma once
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "real_time_tools/timer.hpp"
+
+#include "time_series/interface.hpp"
+#include "time_series/internal/base.hpp"
+#include "time_series/internal/segment.hpp"
+#include "time_series/internal/specialized_classes.hpp"
+
+namespace time_series
+{
+/**
+ * Multiprocess time series of variable size payloads (bytes).
+ *
+ * All data lives in a single shared memory segment (see
+ * internal/segment.hpp), the payloads being stored one after the other in
+ * a ring buffer of bytes (the arena). The memory used is therefore
+ * proportional to the volume of data, rather than to max_length times
+ * the size of the largest payload. An element is dropped (i.e. becomes
+ * older than oldest_timeindex()) either when max_length newer elements
+ * have been appended, or when its payload gets overwritten by newer
+ * payloads.
+ *
+ * As for MultiprocessTimeSeries, a leader instance creates the segment
+ * (and wipes it on destruction) and followers attach to it.
+ */
+class MultiprocessPayloadTimeSeries
+    : public internal::TimeSeriesBase<internal::MultiProcessesPayloadArena,
+                                      std::string>
+{
+    typedef internal::MultiProcessesPayloadArena P;
+
+public:
+    /**
+     * @param segment_id the id of the segment to point to
+     * @param max_length (leader only) max number of elements
+     * @param arena_size (leader only) size in bytes of the payload arena.
+     * Payloads larger than the arena can not be appended.
+     * @param leader if true, creates the shared memory segment, which
+     * is wiped on destruction. Otherwise attaches to the segment of the
+     * leader (std::runtime_error thrown if there is none).
+     * @param start_timeindex (leader only) time index of the first element
+     * @param page_backing (leader only) pages requested for the shared
+     * memory, see memory_options.hpp
+     * @param memory_commit how the shared memory should be committed
+     * in this process, see memory_options.hpp
+     */
+    MultiprocessPayloadTimeSeries(
+        const std::string& segment_id,
+        size_t max_length,
+        size_t arena_size,
+        bool leader = true,
+        Index start_timeindex = 0,
+        PageBacking page_backing = PageBacking::DEFAULT_PAGES,
+        MemoryCommit memory_commit = MemoryCommit::DEFAULT)
+        : internal::TimeSeriesBase<P, std::string>(start_timeindex)
+    {
+        std::shared_ptr<internal::Segment> segment;
+        if (leader)
+        {
+            if (arena_size == 0)
+            {
+                throw std::invalid_argument(
+                    "MultiprocessPayloadTimeSeries: arena size should not be "
+                    "zero");
+            }
+            segment = internal::Segment::create(segment_id,
+                                                max_length,
+                                                Payloads::slot_size(),
+                                                true,
+                                                type_hash(),
+                                                start_timeindex,
+                                                leader,
+                                                page_backing,
+                                                memory_commit,
+                                                arena_size);
+        }
+        else
+        {
+            segment = internal::Segment::attach(
+                segment_id, type_hash(), memory_commit);
+        }
+        internal::SegmentHeader* header = segment->header();
+        this->indexes_ptr_ =
+            std::shared_ptr<internal::Indexes>(segment, &header->indexes);
+        this->mutex_ptr_ = std::make_shared<internal::Mutex<P>>(segment);
+        this->condition_ptr_ =
+            std::make_shared<internal::ConditionVariable<P>>(segment);
+        this->history_elements_ptr_ = std::make_shared<Payloads>(
+            segment, segment->slots(), header->max_length);
+        this->history_timestamps_ptr_ =
+            std::make_shared<internal::Vector<P, Timestamp>>(
+                segment,
+                reinterpret_cast<char*>(segment->timestamps()),
+                header->max_length);
+    }
+
+    MultiprocessPayloadTimeSeries(
+        MultiprocessPayloadTimeSeries&& other) noexcept
+        : internal::TimeSeriesBase<P, std::string>(
+              std::forward<MultiprocessPayloadTimeSeries>(other))
+    {
+    }
+
+    /**
+     * returns a leader instance
+     * (see the constructor for the arguments)
+     */
+    static MultiprocessPayloadTimeSeries create_leader(
+        const std::string& segment_id,
+        size_t max_length,
+        size_t arena_size,
+        Index start_timeindex = 0,
+        PageBacking page_backing = PageBacking::DEFAULT_PAGES,
+        MemoryCommit memory_commit = MemoryCommit::DEFAULT)
+    {
+        return MultiprocessPayloadTimeSeries(segment_id,
+                                             max_length,
+                                             arena_size,
+                                             true,
+                                             start_timeindex,
+                                             page_backing,
+                                             memory_commit);
+    }
+
+    //! @brief same as create_leader but returning a shared_ptr.
+    static std::shared_ptr<MultiprocessPayloadTimeSeries> create_leader_ptr(
+        const std::string& segment_id,
+        size_t max_length,
+        size_t arena_size,
+        Index start_timeindex = 0,
+        PageBacking page_backing = PageBacking::DEFAULT_PAGES,
+        MemoryCommit memory_commit = MemoryCommit::DEFAULT)
+    {
+        return std::make_shared<MultiprocessPayloadTimeSeries>(segment_id,
+                                                               max_length,
+                                                               arena_size,
+                                                               true,
+                                                               start_timeindex,
+                                                               page_backing,
+                                                               memory_commit);
+    }
+
+    /**
+     * returns a follower instance. A std::runtime_error is thrown
+     * if no leader created the segment.
+     */
+    static MultiprocessPayloadTimeSeries create_follower(
+        const std::string& segment_id,
+        MemoryCommit memory_commit = MemoryCommit::DEFAULT)
+    {
+        return MultiprocessPayloadTimeSeries(segment_id,
+                                             0,
+                                             0,
+                                             false,
+                                             0,
+                                             PageBacking::DEFAULT_PAGES,
+                                             memory_commit);
+    }
+
+    //! @brief same as create_follower but returning a shared_ptr.
+    static std::shared_ptr<MultiprocessPayloadTimeSeries> create_follower_ptr(
+        const std::string& segment_id,
+        MemoryCommit memory_commit = MemoryCommit::DEFAULT)
+    {
+        return std::make_shared<MultiprocessPayloadTimeSeries>(
+            segment_id,
+            0,
+            0,
+            false,
+            0,
+            PageBacking::DEFAULT_PAGES,
+            memory_commit);
+    }
+
+    //! @brief size (in bytes) of the payload arena
+    size_t arena_size() const
+    {
+        return this->history_elements_ptr_->arena_size();
+    }
+
+    //! @brief number of elements currently in the time series
+    size_t length() const
+    {
+        if (this->is_empty())
+        {
+            return 0;
+        }
+        return static_cast<size_t>(
+            this->indexes_ptr_->newest.load(std::memory_order_acquire) -
+            this->indexes_ptr_->oldest.load(std::memory_order_acquire) + 1);
+    }
+
+    /**
+     * @brief Appends the payload, dropping the oldest elements
+     * which payloads get overwritten.
+     * @throws std::invalid_argument if the payload is larger than the arena.
+     */
+    void append(const std::string& payload)
+    {
+        Payloads& payloads = *this->history_elements_ptr_;
+        if (payload.size() > payloads.arena_size())
+        {
+            throw std::invalid_argument(
+                "MultiprocessPayloadTimeSeries: payload of " +
+                std::to_string(payload.size()) +
+                " bytes larger than the arena (" +
+                std::to_string(payloads.arena_size()) + " bytes)");
+        }
+        bool has_waiters;
+        {
+            internal::Lock<P> lock(*this->mutex_ptr_);
+            this->read_indexes();
+            this->begin_append();
+            this->newest_timeindex_++;
+            if (this->newest_timeindex_ - this->oldest_timeindex_ + 1 >
+                static_cast<Index>(payloads.size()))
+            {
+                this->oldest_timeindex_++;
+            }
+            // dropping the elements which payloads will be overwritten
+            std::uint64_t end =
+                payloads.next_position(payload.size()) + payload.size();
+            while (this->oldest_timeindex_ < this->newest_timeindex_ &&
+                   payloads.payload_position(this->oldest_timeindex_ %
+                                             payloads.size()) +
+                           payloads.arena_size() <
+                       end)
+            {
+                this->oldest_timeindex_++;
+            }
+            Index history_index = this->newest_timeindex_ % payloads.size();
+            payloads.set(history_index, payload);
+            this->history_timestamps_ptr_->set(
+                history_index, real_time_tools::Timer::get_current_time_ms());
+            this->write_indexes();
+            this->end_append();
+            has_waiters = this->condition_ptr_->has_waiters();
+        }
+        if (has_waiters)
+        {
+            this->condition_ptr_->notify_all();
+        }
+    }
+
+    /**
+     * @brief Calls f(std::string_view payload) with a view on the payload
+     * stored in the shared memory (i.e. without copy). Waits if the element
+     * is not yet in the time series.
+     * f is called while the time series is locked: it should not call any
+     * method of this time series, and the view should not be used after
+     * f returns (the payload may then get overwritten).
+     * @throws std::invalid_argument if the element is older than the
+     * oldest element.
+     */
+    template <typename F>
+    void visit(const Index& timeindex, F f) const
+    {
+        internal::Lock<P> lock(*this->mutex_ptr_);
+        this->read_indexes();
+        while (this->newest_timeindex_ < timeindex)
+        {
+            this->throw_if_sigint_received();
+            this->wait_on_condition(lock);
+            this->read_indexes();
+        }
+        if (timeindex < this->oldest_timeindex_)
+        {
+            throw std::invalid_argument(
+                "you tried to access time_series element " +
+                std::to_string(timeindex) +
+                " which is too old (oldest in buffer is " +
+                std::to_string(this->oldest_timeindex_) + ").");
+        }
+        const Payloads& payloads = *this->history_elements_ptr_;
+        f(payloads.view(timeindex % payloads.size()));
+    }
+
+private:
+    typedef internal::Vector<P, std::string> Payloads;
+
+    static std::uint64_t type_hash()
+    {
+        // (distinct from the hash of MultiprocessTimeSeries<std::string,
+        // SingleSegment>, which uses another layout)
+        return internal::type_hash<Payloads>();
+    }
+};
+
+}  // namespace time_series
@@ -7,11 +7,17 @@
 
 #pragma once
 
+#include <new>
+#include <type_traits>
+
 // virtual class specifying all functions
 // a time_series class should implement
 // Defines also Index and Timestamp
 #include "time_series/interface.hpp"
 
+// how the elements are stored in the shared memory
+#include "time_series/element_storage.hpp"
+
 // all common code to TimeSeries and
 // multiprocesses TimeSeries
 #include "time_series/internal/base.hpp"
@@ -21,6 +27,12 @@
 // MultiprocessTimeSeries. Those are defined there.
 #include "time_series/internal/specialized_classes.hpp"
 
+// shared memory in which the indexes are stored
+#include "time_series/internal/shared_memory_region.hpp"
+
+// single segment layout
+#include "time_series/internal/segment.hpp"
+
 namespace time_series
 {
 // various shared memory segments are created based on the
@@ -33,18 +45,41 @@ static const std::string shm_elements("_elements");
 static const std::string shm_timestamps("_timestamps");
 static const std::string shm_mutex("_mutex");
 static const std::string shm_condition_variable("_condition_variable");
+static const std::string shm_period("_period");
 }  // namespace internal
 
+/**
+ * Layouts of the shared memory used by MultiprocessTimeSeries:
+ * - MultipleSegments (default): the indexes, elements, timestamps, mutex and
+ *   condition variable are stored in distinct shared memory segments.
+ * - SingleSegment: metadata, indexes, synchronization primitives,
+ *   timestamps and elements are stored in a single shared memory segment,
+ *   to which followers attach with a single shm_open and mmap
+ *   (see internal/segment.hpp).
+ * Leader and followers of a same segment_id must use the same layout.
+ */
+typedef internal::MultiProcesses MultipleSegments;
+typedef internal::MultiProcessesSingleSegment SingleSegment;
+
 /**
  * Multiprocess Time Series. Several instances hosted
  * by different processes, if pointing
  * to the same shared memory segment (as specified by the segment_id),
  * may read/write from the same underlying time series.
+ * Policies: see policies.hpp. Leader and followers of a same segment_id
+ * must use the same policies.
  */
-template <typename T = int>
+template <typename T = int,
+          typename Layout = MultipleSegments,
+          typename Policies = DefaultPolicies>
 class MultiprocessTimeSeries
-    : public internal::TimeSeriesBase<internal::MultiProcesses, T>
+    : public internal::TimeSeriesBase<Layout, T, Policies>
 {
+    typedef internal::TimeSeriesBase<Layout, T, Policies> Base;
+
+    static constexpr bool single_segment =
+        std::is_same<Layout, SingleSegment>::value;
+
 public:
     /**
      * @deprecated uses the factory functions create_leader or
@@ -59,45 +94,76 @@ public:
      * Instantiating a  first MultiprocessTimeSeries with leader set to false
      * will result in undefined behavior. When the leader instance is destroyed,
      * other instances are pointing to the shared segment may crash or hang.
+     * (SingleSegment layout: followers ignore max_length and start_timeindex,
+     * which are read from the segment, and throw a std::runtime_error
+     * if no leader created the segment)
+     * @param page_backing (leader only) pages requested for the shared
+     * memory, see memory_options.hpp. Only supported by the SingleSegment
+     * layout (the MultipleSegments layout uses default pages).
+     * @param memory_commit how the shared memory should be committed
+     * in this process, see memory_options.hpp. Only supported by the
+     * SingleSegment layout.
+     * @param lock_protocol (leader only) protocol of the mutex, see
+     * lock_options.hpp. PRIORITY_INHERITANCE is only supported by the
+     * SingleSegment layout (std::invalid_argument thrown otherwise).
+     * @throws std::runtime_error (SingleSegment follower) if the leader
+     * does (not) store timestamps, unlike the clock policy.
      */
-    MultiprocessTimeSeries(std::string segment_id,
-                           size_t max_length,
-                           bool leader = true,
-                           Index start_timeindex = 0)
-        : internal::TimeSeriesBase<internal::MultiProcesses, T>(
-              start_timeindex),
-          indexes_(segment_id + internal::shm_indexes, 4, leader, false)
+    MultiprocessTimeSeries(
+        std::string segment_id,
+        size_t max_length,
+        bool leader = true,
+        Index start_timeindex = 0,
+        PageBacking page_backing = PageBacking::DEFAULT_PAGES,
+        MemoryCommit memory_commit = MemoryCommit::DEFAULT,
+        LockProtocol lock_protocol = LockProtocol::DEFAULT)
+        : Base(start_timeindex)
     {
-        this->mutex_ptr_ =
-            std::make_shared<internal::Mutex<internal::MultiProcesses>>(
-                segment_id + internal::shm_mutex, leader);
-        this->condition_ptr_ = std::make_shared<
-            internal::ConditionVariable<internal::MultiProcesses>>(
-            segment_id + internal::shm_condition_variable, leader);
-        this->history_elements_ptr_ =
-            std::make_shared<internal::Vector<internal::MultiProcesses, T>>(
-                max_length, segment_id + internal::shm_elements, leader);
-        this->history_timestamps_ptr_ = std::make_shared<
-            internal::Vector<internal::MultiProcesses, Timestamp>>(
-            max_length, segment_id + internal::shm_timestamps, leader);
         if (leader)
         {
-            write_indexes();
+            Base::checked_max_length(max_length);
         }
-        if (leader)
+        if (!single_segment && lock_protocol != LockProtocol::DEFAULT)
         {
-            // sharing the max_length in the shared memory
-            // (follower can query size for proper construction)
-            shared_memory::set<size_t>(segment_id, "max_length", max_length);
-            shared_memory::set<Index>(
-                segment_id, "start_timeindex", start_timeindex);
+            throw std::invalid_argument(
+                "MultiprocessTimeSeries: the lock protocol " +
+                to_string(lock_protocol) +
+                " requires the SingleSegment layout");
+        }
+        if constexpr (single_segment)
+        {
+            std::shared_ptr<internal::Segment> segment;
+            if (leader)
+            {
+                segment = internal::Segment::create(
+                    segment_id,
+                    max_length,
+                    internal::Vector<Layout, T>::slot_size(),
+                    Policies::clock::timestamps,
+                    internal::type_hash<T>(),
+                    start_timeindex,
+                    leader,
+                    page_backing,
+                    memory_commit,
+                    0,
+                    lock_protocol);
+            }
+            else
+            {
+                segment = internal::Segment::attach(
+                    segment_id, internal::type_hash<T>(), memory_commit);
+            }
+            init_single_segment(segment);
+        }
+        else
+        {
+            init_multiple_segments(
+                segment_id, max_length, leader, start_timeindex);
         }
     }
 
-    MultiprocessTimeSeries(MultiprocessTimeSeries<T>&& other) noexcept
-        : internal::TimeSeriesBase<internal::MultiProcesses, T>(
-              std::forward<MultiprocessTimeSeries<T>>(other)),
-          indexes_(other.indexes_)
+    MultiprocessTimeSeries(MultiprocessTimeSeries&& other) noexcept
+        : Base(std::forward<MultiprocessTimeSeries>(other))
     {
     }
 
@@ -107,9 +173,19 @@ public:
      */
     static size_t get_max_length(const std::string& segment_id)
     {
-        size_t s;
-        shared_memory::get<size_t>(segment_id, "max_length", s);
-        return s;
+        if constexpr (single_segment)
+        {
+            return internal::Segment::attach(segment_id,
+                                             internal::type_hash<T>())
+                ->header()
+                ->max_length;
+        }
+        else
+        {
+            size_t s;
+            shared_memory::get<size_t>(segment_id, "max_length", s);
+            return s;
+        }
     }
 
     /**
@@ -118,35 +194,68 @@ public:
      */
     static Index get_start_timeindex(const std::string& segment_id)
     {
-        Index index;
-        shared_memory::get<Index>(segment_id, "start_timeindex", index);
-        return index;
+        if constexpr (single_segment)
+        {
+            return internal::Segment::attach(segment_id,
+                                             internal::type_hash<T>())
+                ->header()
+                ->indexes.start.load();
+        }
+        else
+        {
+            Index index;
+            shared_memory::get<Index>(segment_id, "start_timeindex", index);
+            return index;
+        }
     }
 
     /**
      * returns a leader instance of MultiprocessTimeSeries<T>
      * @param segment_id the id of the segment to point to
      * @param max_length max number of elements in the time series
+     * @param page_backing pages requested for the shared memory
+     * (see memory_options.hpp). The pages actually used are returned by
+     * page_backing().
+     * @param memory_commit how the shared memory should be committed
+     * (see memory_options.hpp and memory_commit()).
+     * @param lock_protocol protocol of the mutex, shared by the followers
+     * (see lock_options.hpp).
      */
-    static MultiprocessTimeSeries<T> create_leader(
+    static MultiprocessTimeSeries create_leader(
         const std::string& segment_id,
         size_t max_length,
-        Index start_timeindex = 0)
+        Index start_timeindex = 0,
+        PageBacking page_backing = PageBacking::DEFAULT_PAGES,
+        MemoryCommit memory_commit = MemoryCommit::DEFAULT,
+        LockProtocol lock_protocol = LockProtocol::DEFAULT)
     {
         bool leader = true;
-        return MultiprocessTimeSeries<T>(
-            segment_id, max_length, leader, start_timeindex);
+        return MultiprocessTimeSeries(segment_id,
+                                      max_length,
+                                      leader,
+                                      start_timeindex,
+                                      page_backing,
+                                      memory_commit,
+                                      lock_protocol);
     }
 
     //! @brief same as create_leader but returning a shared_ptr.
-    static std::shared_ptr<MultiprocessTimeSeries<T>> create_leader_ptr(
+    static std::shared_ptr<MultiprocessTimeSeries> create_leader_ptr(
         const std::string& segment_id,
         size_t max_length,
-        Index start_timeindex = 0)
+        Index start_timeindex = 0,
+        PageBacking page_backing = PageBacking::DEFAULT_PAGES,
+        MemoryCommit memory_commit = MemoryCommit::DEFAULT,
+        LockProtocol lock_protocol = LockProtocol::DEFAULT)
     {
         bool leader = true;
-        return std::make_shared<MultiprocessTimeSeries<T>>(
-            segment_id, max_length, leader, start_timeindex);
+        return std::make_shared<MultiprocessTimeSeries>(segment_id,
+                                                        max_length,
+                                                        leader,
+                                                        start_timeindex,
+                                                        page_backing,
+                                                        memory_commit,
+                                                        lock_protocol);
     }
 
     /**
@@ -155,43 +264,147 @@ public:
      * instance has been created first. A std::runtime_error will
      * be thrown otherwise.
      * @param segment_id the id of the segment to point to
+     * @param memory_commit how the shared memory should be committed
+     * in this process (see memory_options.hpp and memory_commit()).
      */
-    static MultiprocessTimeSeries<T> create_follower(
-        const std::string& segment_id)
+    static MultiprocessTimeSeries create_follower(
+        const std::string& segment_id,
+        MemoryCommit memory_commit = MemoryCommit::DEFAULT)
     {
         bool leader = false;
-        Index start_timeindex;
-        size_t max_length;
-        get_max_length_and_start_index_from_leader(
-            segment_id, &max_length, &start_timeindex);
+        Index start_timeindex = 0;
+        size_t max_length = 0;
+        // (single segment: read from the segment when attaching)
+        if constexpr (!single_segment)
+        {
+            get_max_length_and_start_index_from_leader(
+                segment_id, &max_length, &start_timeindex);
+        }
 
-        return MultiprocessTimeSeries<T>(
-            segment_id, max_length, leader, start_timeindex);
+        return MultiprocessTimeSeries(segment_id,
+                                      max_length,
+                                      leader,
+                                      start_timeindex,
+                                      PageBacking::DEFAULT_PAGES,
+                                      memory_commit);
     }
 
     //! @brief same as create_follower but returning a shared_ptr.
-    static std::shared_ptr<MultiprocessTimeSeries<T>> create_follower_ptr(
-        const std::string& segment_id)
+    static std::shared_ptr<MultiprocessTimeSeries> create_follower_ptr(
+        const std::string& segment_id,
+        MemoryCommit memory_commit = MemoryCommit::DEFAULT)
     {
         bool leader = false;
-        Index start_timeindex;
-        size_t max_length;
-        get_max_length_and_start_index_from_leader(
-            segment_id, &max_length, &start_timeindex);
+        Index start_timeindex = 0;
+        size_t max_length = 0;
+        if constexpr (!single_segment)
+        {
+            get_max_length_and_start_index_from_leader(
+                segment_id, &max_length, &start_timeindex);
+        }
 
-        return std::make_shared<MultiprocessTimeSeries<T>>(
-            segment_id, max_length, leader, start_timeindex);
+        return std::make_shared<MultiprocessTimeSeries>(
+            segment_id,
+            max_length,
+            leader,
+            start_timeindex,
+            PageBacking::DEFAULT_PAGES,
+            memory_commit);
+    }
+
+    /**
+     * returns a leader instance attached to the segment of a previous
+     * leader which crashed (or exited without wiping the segment), keeping
+     * its elements: the new leader appends after the newest element, and
+     * running followers keep working. The (robust) mutex is recovered if
+     * the previous leader died while holding it
+     * (see internal::Segment::recover). SingleSegment layout only.
+     * @param segment_id the id of the segment to point to
+     * @param memory_commit how the shared memory should be committed
+     * in this process (see memory_options.hpp and memory_commit()).
+     * @throws std::runtime_error if there is no (valid) segment, or if
+     * the previous leader process is still running.
+     */
+    static MultiprocessTimeSeries reattach_leader(
+        const std::string& segment_id,
+        MemoryCommit memory_commit = MemoryCommit::DEFAULT)
+    {
+        static_assert(single_segment,
+                      "reattach_leader requires the SingleSegment layout");
+        return MultiprocessTimeSeries(internal::Segment::reattach(
+            segment_id, internal::type_hash<T>(), memory_commit));
+    }
+
+    //! @brief same as reattach_leader but returning a shared_ptr.
+    static std::shared_ptr<MultiprocessTimeSeries> reattach_leader_ptr(
+        const std::string& segment_id,
+        MemoryCommit memory_commit = MemoryCommit::DEFAULT)
+    {
+        static_assert(single_segment,
+                      "reattach_leader requires the SingleSegment layout");
+        return std::shared_ptr<MultiprocessTimeSeries>(
+            new MultiprocessTimeSeries(internal::Segment::reattach(
+                segment_id, internal::type_hash<T>(), memory_commit)));
+    }
+
+    /**
+     * @brief how the elements are stored in the shared memory
+     * (see element_storage.hpp). MultipleSegments layout: elements of
+     * fundamental types are stored as is, others are serialized.
+     */
+    static constexpr StorageMethod storage_method =
+        single_segment ? storage_method_v<T>
+                       : (std::is_fundamental<T>::value
+                              ? StorageMethod::RAW
+                              : StorageMethod::SERIALIZED);
+
+    /**
+     * @brief Calls f(view) with a reference to the element as stored in
+     * the shared memory, i.e. without copy nor decoding: the element
+     * itself (RAW storage) or its flat form (FLAT storage, see
+     * element_storage.hpp). Waits if the element is not yet in the time
+     * series. SingleSegment layout only.
+     * f is called while the time series is locked: it should not call any
+     * method of this time series, and the view should not be used after
+     * f returns (the slot may then get overwritten).
+     * @throws std::invalid_argument if the element is older than the
+     * oldest element.
+     */
+    template <typename F>
+    void visit(const Index& timeindex, F f) const
+    {
+        static_assert(single_segment &&
+                          storage_method != StorageMethod::SERIALIZED,
+                      "visit requires the SingleSegment layout and elements "
+                      "stored raw or flat");
+        internal::Lock<Layout> lock(*this->mutex_ptr_);
+        this->read_indexes();
+        while (this->newest_timeindex_ < timeindex)
+        {
+            this->throw_if_sigint_received();
+            this->wait_on_condition(lock);
+            this->read_indexes();
+        }
+        if (timeindex < this->oldest_timeindex_)
+        {
+            throw std::invalid_argument(
+                "you tried to access time_series element " +
+                std::to_string(timeindex) +
+                " which is too old (oldest in buffer is " +
+                std::to_string(this->oldest_timeindex_) + ").");
+        }
+        f(this->history_elements_ptr_->view(this->slot(timeindex)));
     }
 
     /**
      * similar to the random access operator, but does not deserialized the
-     * accessed element. If the element is of a fundamental type (or an array
-     * of), an std::logic_error is thrown.
+     * accessed element. If the element is not serialized (see
+     * storage_method), an std::logic_error is thrown.
      */
     std::string get_raw(const Index& timeindex)
     {
-        internal::Lock<internal::MultiProcesses> lock(*this->mutex_ptr_);
-        read_indexes();
+        internal::Lock<Layout> lock(*this->mutex_ptr_);
+        this->read_indexes();
         if (timeindex < this->oldest_timeindex_)
         {
             throw std::invalid_argument(
@@ -205,29 +418,122 @@ public:
         {
             this->throw_if_sigint_received();
 
-            this->condition_ptr_->wait(lock);
-            read_indexes();
+            this->wait_on_condition(lock);
+            this->read_indexes();
         }
 
         return this->history_elements_ptr_->get_serialized(
-            timeindex % this->history_elements_ptr_->size());
+            this->slot(timeindex));
     }
 
 protected:
-    void read_indexes() const
+    // (see reattach_leader)
+    MultiprocessTimeSeries(std::shared_ptr<internal::Segment> segment)
+        : Base(segment->header()->indexes.start.load())
+    {
+        init_single_segment(segment);
+    }
+
+    void init_multiple_segments(const std::string& segment_id,
+                                size_t max_length,
+                                bool leader,
+                                Index start_timeindex)
     {
-        indexes_.get(0, this->start_timeindex_);
-        indexes_.get(1, this->oldest_timeindex_);
-        indexes_.get(2, this->newest_timeindex_);
-        indexes_.get(3, this->tagged_timeindex_);
+        // the indexes are stored in their own (cache line sized)
+        // shared memory region, and accessed via atomics
+        std::shared_ptr<internal::SharedMemoryRegion> indexes_region =
+            std::make_shared<internal::SharedMemoryRegion>(
+                segment_id + internal::shm_indexes,
+                sizeof(internal::Indexes),
+                leader,
+                leader);
+        internal::Indexes* indexes =
+            static_cast<internal::Indexes*>(indexes_region->data());
+        if (leader)
+        {
+            new (indexes) internal::Indexes(start_timeindex);
+        }
+        // (aliasing constructor: keeps the region mapped for as long
+        // as the indexes are used)
+        this->indexes_ptr_ =
+            std::shared_ptr<internal::Indexes>(indexes_region, indexes);
+
+        this->mutex_ptr_ = std::make_shared<internal::Mutex<Layout>>(
+            segment_id + internal::shm_mutex, leader);
+        this->condition_ptr_ =
+            std::make_shared<internal::ConditionVariable<Layout>>(
+                segment_id + internal::shm_condition_variable, leader);
+        this->history_elements_ptr_ =
+            std::make_shared<internal::Vector<Layout, T>>(
+                max_length, segment_id + internal::shm_elements, leader);
+        if constexpr (Policies::clock::timestamps)
+        {
+            this->history_timestamps_ptr_ =
+                std::make_shared<internal::Vector<Layout, Timestamp>>(
+                    max_length, segment_id + internal::shm_timestamps, leader);
+        }
+        if constexpr (Policies::period::enabled)
+        {
+            std::shared_ptr<internal::SharedMemoryRegion> period_region =
+                std::make_shared<internal::SharedMemoryRegion>(
+                    segment_id + internal::shm_period,
+                    sizeof(internal::PeriodTracker),
+                    leader,
+                    leader);
+            internal::PeriodTracker* tracker =
+                static_cast<internal::PeriodTracker*>(period_region->data());
+            if (leader)
+            {
+                new (tracker) internal::PeriodTracker();
+            }
+            this->period_tracker_ptr_ =
+                std::shared_ptr<internal::PeriodTracker>(period_region,
+                                                         tracker);
+        }
+        if (leader)
+        {
+            // sharing the max_length in the shared memory
+            // (follower can query size for proper construction)
+            shared_memory::set<size_t>(segment_id, "max_length", max_length);
+            shared_memory::set<Index>(
+                segment_id, "start_timeindex", start_timeindex);
+        }
     }
 
-    void write_indexes()
+    void init_single_segment(std::shared_ptr<internal::Segment> segment)
     {
-        indexes_.set(0, this->start_timeindex_);
-        indexes_.set(1, this->oldest_timeindex_);
-        indexes_.set(2, this->newest_timeindex_);
-        indexes_.set(3, this->tagged_timeindex_);
+        internal::SegmentHeader* header = segment->header();
+        if (header->timestamps != Policies::clock::timestamps)
+        {
+            throw std::runtime_error(
+                std::string("MultiprocessTimeSeries: the segment ") +
+                (header->timestamps ? "has" : "has no") +
+                " timestamps, unlike the clock policy");
+        }
+        // (aliasing constructor: keeps the segment mapped for as long
+        // as the indexes are used)
+        this->indexes_ptr_ =
+            std::shared_ptr<internal::Indexes>(segment, &header->indexes);
+        this->mutex_ptr_ = std::make_shared<internal::Mutex<Layout>>(segment);
+        this->condition_ptr_ =
+            std::make_shared<internal::ConditionVariable<Layout>>(segment);
+        this->history_elements_ptr_ =
+            std::make_shared<internal::Vector<Layout, T>>(
+                segment, segment->slots(), header->max_length);
+        if constexpr (Policies::clock::timestamps)
+        {
+            this->history_timestamps_ptr_ =
+                std::make_shared<internal::Vector<Layout, Timestamp>>(
+                    segment,
+                    reinterpret_cast<char*>(segment->timestamps()),
+                    header->max_length);
+        }
+        if constexpr (Policies::period::enabled)
+        {
+            this->period_tracker_ptr_ =
+                std::shared_ptr<internal::PeriodTracker>(
+                    segment, &header->period_tracker);
+        }
     }
 
     /**
@@ -263,8 +569,6 @@ protected:
             throw std::runtime_error(stream.str());
         }
     }
-
-    mutable shared_memory::array<Index> indexes_;
 };
 
 /**
@@ -0,0 +1,43 @@
+/**
+ * @file period_statistics.hpp
+ * license License BSD-3-Clause
+ * @copyright Copyright (c) 2019, Max Planck Gesellschaft.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+namespace time_series
+{
+/**
+ * @brief Statistics of the period of the appends of a time series, i.e.
+ * of the interval (in milliseconds) between the timestamps of consecutive
+ * elements (see the TrackPeriod policy in policies.hpp).
+ *
+ * Mean and variance are exponentially weighted moving averages, so that
+ * they follow the recent behavior of the producer (see
+ * set_period_ewma_weight). Min, max and deadline misses are counted since
+ * the creation of the time series (or the last reset).
+ */
+struct PeriodStatistics
+{
+    //! number of intervals (i.e. appends minus one)
+    std::int64_t count = 0;
+    double mean_ms = 0;
+    double variance_ms2 = 0;
+    double min_ms = 0;
+    double max_ms = 0;
+    //! intervals longer than deadline_ms (if deadline_ms is not 0)
+    std::int64_t deadline_misses = 0;
+    double deadline_ms = 0;
+
+    //! jitter: standard deviation of the period
+    double stddev_ms() const
+    {
+        return std::sqrt(variance_ms2);
+    }
+};
+
+}  // namespace time_series
@@ -0,0 +1,137 @@
+/**
+ * @file policies.hpp
+ * license License BSD-3-Clause
+ * @copyright Copyright (c) 2019, Max Planck Gesellschaft.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+#include "real_time_tools/timer.hpp"
+
+#include "time_series/interface.hpp"
+
+namespace time_series
+{
+/**
+ * Compile time policies of TimeSeries and MultiprocessTimeSeries,
+ * so that unused features cost nothing at runtime.
+ * (the locking primitive is selected by the process / layout of the time
+ * series, see specialized_classes.hpp)
+ */
+
+// ------- clock (timestamps) ------- //
+
+//! timestamps from real_time_tools (default)
+struct WallClock
+{
+    static constexpr bool timestamps = true;
+    static Timestamp now_ms()
+    {
+        return real_time_tools::Timer::get_current_time_ms();
+    }
+};
+
+//! timestamps from the monotonic clock (ms since an unspecified origin)
+struct MonotonicClock
+{
+    static constexpr bool timestamps = true;
+    static Timestamp now_ms()
+    {
+        return std::chrono::duration<Timestamp, std::milli>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+};
+
+/**
+ * no timestamps: append does not read any clock, no memory is
+ * allocated for the timestamps, and timestamp_ms / timestamp_s throw
+ * a std::logic_error.
+ */
+struct NoTimestamps
+{
+    static constexpr bool timestamps = false;
+};
+
+// ------- wait ------- //
+
+/**
+ * readers wait on a condition variable, which append notifies
+ * (if readers are waiting). Default.
+ */
+struct BlockingWait
+{
+    static constexpr bool notify = true;
+};
+
+/**
+ * readers poll for new elements every PeriodUs microseconds (releasing the
+ * lock in between), so that append never checks for waiters nor notifies.
+ */
+template <long PeriodUs = 100>
+struct PollingWait
+{
+    static_assert(PeriodUs > 0, "PollingWait: period should be positive");
+    static constexpr bool notify = false;
+    static constexpr double period_s = PeriodUs * 1e-6;
+};
+
+// ------- capacity ------- //
+
+//! max length provided to the constructor (default)
+struct DynamicCapacity
+{
+    static constexpr std::size_t max_length = 0;
+};
+
+/**
+ * max length known at compile time (the constructor should be given
+ * the same max length). Slots are computed with a constant modulo
+ * (a mask if N is a power of two).
+ */
+template <std::size_t N>
+struct FixedCapacity
+{
+    static_assert(N > 0, "FixedCapacity: max length should be positive");
+    static constexpr std::size_t max_length = N;
+};
+
+// ------- period statistics ------- //
+
+//! no statistics of the period of the appends (default)
+struct NoPeriodStatistics
+{
+    static constexpr bool enabled = false;
+};
+
+/**
+ * append updates (in O(1)) running statistics of the interval between
+ * the timestamps of consecutive elements, readable without locking
+ * (see period_statistics() and period_statistics.hpp). Requires
+ * timestamps.
+ */
+struct TrackPeriod
+{
+    static constexpr bool enabled = true;
+};
+
+template <typename Clock = WallClock,
+          typename Wait = BlockingWait,
+          typename Capacity = DynamicCapacity,
+          typename Period = NoPeriodStatistics>
+struct TimeSeriesPolicies
+{
+    static_assert(!Period::enabled || Clock::timestamps,
+                  "TrackPeriod requires timestamps");
+    typedef Clock clock;
+    typedef Wait wait;
+    typedef Capacity capacity;
+    typedef Period period;
+};
+
+typedef TimeSeriesPolicies<> DefaultPolicies;
+
+}  // namespace time_series
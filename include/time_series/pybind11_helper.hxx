@@ -52,8 +52,23 @@ void _create_python_bindings(pybind11::module& m, const std::string& classname)
 
         std::string leader = std::string("create_leader_") + classname;
         std::string follower = std::string("create_follower_") + classname;
-        m.def(leader.c_str(), &TS::create_leader_ptr);
-        m.def(follower.c_str(), &TS::create_follower_ptr);
+        m.def(
+            leader.c_str(),
+            [](const std::string& segment_id,
+               size_t max_length,
+               time_series::Index start_timeindex) {
+                return TS::create_leader_ptr(
+                    segment_id, max_length, start_timeindex);
+            },
+            pybind11::arg("segment_id"),
+            pybind11::arg("max_length"),
+            pybind11::arg("start_timeindex") = 0);
+        m.def(
+            follower.c_str(),
+            [](const std::string& segment_id) {
+                return TS::create_follower_ptr(segment_id);
+            },
+            pybind11::arg("segment_id"));
         m.def("clear_memory", &time_series::clear_memory);
     }
 }
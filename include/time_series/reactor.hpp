@@ -0,0 +1,123 @@
+/**
+ * @file reactor.hpp
+ * license License BSD-3-Clause
+ * @copyright Copyright (c) 2019, Max Planck Gesellschaft.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "time_series/interface.hpp"
+#include "time_series/internal/event_fd.hpp"
+
+namespace time_series
+{
+/**
+ * @brief Calls callbacks once elements get appended to time series whose
+ * appends can not call them directly, i.e. time series filled by another
+ * process (MultiprocessTimeSeries followers). For TimeSeries, see
+ * TimeSeries::when_available, which does not need a reactor.
+ *
+ * A single thread polls (lock free) the newest time index of the time
+ * series with pending callbacks or event file descriptors, at the given
+ * period. It sleeps while there are none. Callbacks are called by this
+ * thread: they should be short, e.g. posting the actual work to an
+ * executor (see coroutines.hpp).
+ */
+class Reactor
+{
+public:
+    /**
+     * @param period_s polling period (in seconds) while callbacks are
+     * pending, i.e. the max latency added between an append and the call
+     * of the corresponding callback.
+     * @throws std::invalid_argument if period_s is not positive.
+     */
+    Reactor(double period_s = 0.0005);
+
+    //! @brief stops the polling thread, pending callbacks are not called
+    ~Reactor();
+
+    Reactor(const Reactor &) = delete;
+    Reactor &operator=(const Reactor &) = delete;
+
+    /**
+     * @brief Registers a callback to be called once the element of index
+     * timeindex has been appended to the time series, which should
+     * outlive the call of the callback (or this reactor).
+     * @returns false (and the callback is not registered) if the element
+     * has already been appended.
+     */
+    template <typename T>
+    bool when_available(const TimeSeriesInterface<T> &time_series,
+                        const Index &timeindex,
+                        std::function<void()> callback)
+    {
+        if (time_series.newest_timeindex(false) >= timeindex)
+        {
+            return false;
+        }
+        const TimeSeriesInterface<T> *ts = &time_series;
+        Index index = timeindex;
+        add([ts, index]() { return ts->newest_timeindex(false) >= index; },
+            std::move(callback));
+        return true;
+    }
+
+    //! @brief number of callbacks not called yet
+    std::size_t pending() const;
+
+    /**
+     * @brief Returns a file descriptor (eventfd, created by this call)
+     * which becomes readable when elements get appended to the time series
+     * (see TimeSeries::event_fd for usage), e.g. for adding a time series
+     * filled by another process to an epoll event loop. A single reactor
+     * may serve any number of time series. The time series should outlive
+     * the fd, which is closed by remove_event_fd or by the destructor.
+     * @throws std::runtime_error if the eventfd can not be created.
+     */
+    template <typename T>
+    int event_fd(const TimeSeriesInterface<T> &time_series)
+    {
+        const TimeSeriesInterface<T> *ts = &time_series;
+        return add_event_fd([ts]() { return ts->newest_timeindex(false); });
+    }
+
+    //! @brief stops signaling and closes a fd returned by event_fd
+    void remove_event_fd(int fd);
+
+private:
+    struct Waiter
+    {
+        std::function<bool()> ready;
+        std::function<void()> callback;
+    };
+
+    struct Watcher
+    {
+        std::function<Index()> newest;
+        Index last;
+        std::unique_ptr<internal::EventFd> event_fd;
+    };
+
+    void add(std::function<bool()> ready, std::function<void()> callback);
+    int add_event_fd(std::function<Index()> newest);
+    void run();
+
+    double period_s_;
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+    std::vector<Waiter> waiters_;
+    std::vector<Watcher> watchers_;
+    bool stop_;
+    std::thread thread_;
+};
+
+}  // namespace time_series
@@ -0,0 +1,104 @@
+/**
+ * @file segment_monitor.hpp
+ * license License BSD-3-Clause
+ * @copyright Copyright (c) 2019, Max Planck Gesellschaft.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "time_series/interface.hpp"
+#include "time_series/internal/period_tracker.hpp"
+#include "time_series/internal/indexes.hpp"
+#include "time_series/internal/segment.hpp"
+#include "time_series/internal/shared_memory_region.hpp"
+#include "time_series/period_statistics.hpp"
+
+namespace time_series
+{
+/**
+ * @brief State of a multiprocess time series, as read from its indexes
+ * (see SegmentMonitor).
+ */
+struct SegmentStatus
+{
+    std::string segment_id;
+    //! true for the SingleSegment layout, false for MultipleSegments
+    bool single_segment;
+    Index start;
+    Index oldest;
+    Index newest;
+    Index tagged;
+    size_t max_length;
+    //! number of readers waiting for an element (-1 if unknown)
+    long waiters;
+    //! process of the leader (0 if unknown)
+    int leader_pid;
+    //! false if the leader process is known to be dead
+    bool leader_alive;
+    //! statistics of the period of the appends, as tracked by the writers
+    //! (count is 0 if the time series does not have the TrackPeriod policy)
+    PeriodStatistics period;
+
+    //! number of elements in the time series (at most max_length)
+    size_t length() const
+    {
+        if (newest < oldest)
+        {
+            return 0;
+        }
+        return std::min(static_cast<size_t>(newest - oldest + 1), max_length);
+    }
+};
+
+/**
+ * @brief Passive observer of a multiprocess time series (of any type of
+ * elements and of either layout), for monitoring tools
+ * (see time_series_top).
+ *
+ * Only the indexes and the period statistics (and, for the SingleSegment
+ * layout, the rest of the header of the segment) are read, without locking
+ * (the statistics being protected by a sequence counter): monitoring never
+ * contends with the writers and readers of the time series. The values
+ * returned by status are therefore not read atomically together.
+ */
+class SegmentMonitor
+{
+public:
+    /**
+     * @throws std::runtime_error if no leader created a time series
+     * of this segment_id.
+     */
+    SegmentMonitor(const std::string &segment_id);
+
+    const std::string &segment_id() const
+    {
+        return segment_id_;
+    }
+
+    SegmentStatus status() const;
+
+    /**
+     * @brief ids of the multiprocess time series currently in shared
+     * memory (of both layouts, including the time series of huge pages),
+     * sorted. Some may be leftovers of leaders which did not exit cleanly.
+     */
+    static std::vector<std::string> discover();
+
+private:
+    std::string segment_id_;
+    // SingleSegment layout
+    std::shared_ptr<internal::Segment> segment_;
+    // MultipleSegments layout
+    std::shared_ptr<internal::SharedMemoryRegion> indexes_region_;
+    // (nullptr if the time series does not track its period)
+    std::shared_ptr<internal::SharedMemoryRegion> period_region_;
+    size_t max_length_;
+};
+
+}  // namespace time_series
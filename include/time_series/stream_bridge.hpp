@@ -0,0 +1,669 @@
+/**
+ * @file stream_bridge.hpp
+ * license License BSD-3-Clause
+ * @copyright Copyright (c) 2019, Max Planck Gesellschaft.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "shared_memory/serializer.hpp"
+
+#include "time_series/element_storage.hpp"
+#include "time_series/interface.hpp"
+#include "time_series/internal/segment.hpp"
+#include "time_series/internal/socket.hpp"
+
+namespace time_series
+{
+/**
+ * Mirroring of a time series over a stream socket (TCP, or UNIX domain
+ * socket for processes of the same machine):
+ * - a StreamPublisher tails a time series (e.g. a MultiprocessTimeSeries
+ *   follower), and streams to each connected subscriber batches of
+ *   framed elements, with their indexes and timestamps.
+ * - a StreamSubscriber appends the received elements to a local time
+ *   series.
+ *
+ * Backpressure: each connection has its own cursor, and sends blocking.
+ * A subscriber which does not keep up delays only its own connection,
+ * until its cursor falls behind the oldest element of the time series.
+ * The publisher then resyncs the cursor to the oldest element; the skipped
+ * elements are counted on both sides (StreamPublisher::skipped,
+ * StreamSubscriber::missed), based on the streamed indexes.
+ *
+ * Elements are streamed as they are stored in shared memory (see
+ * element_storage.hpp): trivially copyable elements as bytes, elements with
+ * a flat form as the bytes of their flat form, others serialized. Frames
+ * use the native byte order and a type
+ * hash based on the compiler specific type name: publisher and subscriber
+ * are expected to run on the same architecture, and be compiled with the
+ * same compiler.
+ */
+
+//! @brief address of a stream bridge
+struct StreamEndpoint
+{
+    //! @brief TCP, localhost only (publisher and subscriber)
+    static StreamEndpoint tcp(int port)
+    {
+        return StreamEndpoint{false, "localhost", port};
+    }
+
+    /**
+     * @brief TCP: host name or address of the publisher (subscriber), or
+     * of the interface to listen on (publisher)
+     */
+    static StreamEndpoint tcp(const std::string& host, int port)
+    {
+        return StreamEndpoint{false, host, port};
+    }
+
+    /**
+     * @brief TCP (publisher): listening on all the interfaces. The
+     * streams are not authenticated: any host reaching the port gets
+     * the elements.
+     */
+    static StreamEndpoint tcp_all_interfaces(int port)
+    {
+        return StreamEndpoint{false, "0.0.0.0", port};
+    }
+
+    //! @brief UNIX domain socket
+    static StreamEndpoint unix_socket(const std::string& path)
+    {
+        return StreamEndpoint{true, path, 0};
+    }
+
+    bool is_unix;
+    // host (TCP) or path (UNIX domain socket)
+    std::string address;
+    int port;
+};
+
+namespace internal
+{
+// handshake (sent by the publisher on connection):
+//   | STREAM_MAGIC (u32) | STREAM_VERSION (u32) | type_hash<T>() (u64) |
+// batch frame:
+//   | FRAME_MAGIC (u32) | nb elements (u32) |
+//   nb times: | index (i64) | timestamp ms (f64) | size (u32) | bytes |
+static constexpr std::uint32_t STREAM_MAGIC = 0x54534231;
+static constexpr std::uint32_t STREAM_VERSION = 1;
+static constexpr std::uint32_t FRAME_MAGIC = 0x54534246;
+
+// encoding of the elements, based on their storage method (see
+// element_storage.hpp)
+template <typename T>
+class StreamCodec
+{
+public:
+    static constexpr StorageMethod method = storage_method_v<T>;
+    // element or flat form (raw and flat elements)
+    typedef typename StoredType<T>::type Stored;
+
+    void encode(const T& t, std::string& out)
+    {
+        if constexpr (method == StorageMethod::RAW)
+        {
+            append(out, static_cast<std::uint32_t>(sizeof(T)));
+            out.append(reinterpret_cast<const char*>(&t), sizeof(T));
+        }
+        else if constexpr (method == StorageMethod::FLAT)
+        {
+            Stored flat{};
+            FlatForm<T>::to_flat(t, flat);
+            append(out, static_cast<std::uint32_t>(sizeof(Stored)));
+            out.append(reinterpret_cast<const char*>(&flat), sizeof(Stored));
+        }
+        else
+        {
+            const std::string& serialized = serializer_.serialize(t);
+            append(out, static_cast<std::uint32_t>(serialized.size()));
+            out.append(serialized);
+        }
+    }
+
+    // (bytes: as written by encode, without the size)
+    void decode(const std::string& bytes, T& t)
+    {
+        if constexpr (method != StorageMethod::SERIALIZED)
+        {
+            if (bytes.size() != sizeof(Stored))
+            {
+                throw std::runtime_error(
+                    "stream bridge: unexpected element size");
+            }
+            if constexpr (method == StorageMethod::RAW)
+            {
+                std::memcpy(&t, bytes.data(), sizeof(T));
+            }
+            else
+            {
+                Stored flat;
+                std::memcpy(&flat, bytes.data(), sizeof(Stored));
+                FlatForm<T>::from_flat(flat, t);
+            }
+        }
+        else
+        {
+            serializer_.deserialize(bytes, t);
+        }
+    }
+
+    // max size of an encoded element (without the size)
+    static std::size_t max_size()
+    {
+        if constexpr (method != StorageMethod::SERIALIZED)
+        {
+            return sizeof(Stored);
+        }
+        else
+        {
+            return static_cast<std::size_t>(
+                shared_memory::Serializer<T>::serializable_size());
+        }
+    }
+
+    template <typename V>
+    static void append(std::string& out, V value)
+    {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(V));
+    }
+
+private:
+    // (raw and flat elements do not need to be serializable)
+    std::conditional_t<method == StorageMethod::SERIALIZED,
+                       shared_memory::Serializer<T>,
+                       char>
+        serializer_;
+};
+
+}  // namespace internal
+
+/**
+ * @brief Streams the elements of a time series to the subscribers
+ * connecting to the endpoint (see the top of this file).
+ *
+ * @tparam TS the type of the time series, which should provide at(index)
+ * and samples(first, last) (e.g. TimeSeries or MultiprocessTimeSeries)
+ */
+template <typename TS>
+class StreamPublisher
+{
+public:
+    typedef typename std::decay<decltype(
+        std::declval<TS&>().at(Index()).element)>::type T;
+
+    /**
+     * @param time_series the time series to stream, which should
+     * outlive the publisher
+     * @param endpoint the endpoint to listen on (for TCP, port 0 selects
+     * any free port, see port())
+     * @param max_batch max number of elements per frame
+     * @param from_oldest if true, subscribers get the elements from the
+     * oldest element of the time series on, otherwise only the elements
+     * appended after they connected.
+     * @throws std::runtime_error if the endpoint can not be listened on.
+     */
+    StreamPublisher(TS& time_series,
+                    const StreamEndpoint& endpoint,
+                    std::size_t max_batch = 256,
+                    bool from_oldest = false)
+        : time_series_(time_series),
+          max_batch_(std::max<std::size_t>(max_batch, 1)),
+          from_oldest_(from_oldest),
+          stop_(false),
+          sent_(0),
+          skipped_(0)
+    {
+        listen_fd_ =
+            endpoint.is_unix
+                ? internal::listen_unix(endpoint.address)
+                : internal::listen_tcp(endpoint.address, endpoint.port);
+        port_ = endpoint.is_unix ? 0 : internal::bound_port(listen_fd_);
+        accept_thread_ = std::thread(&StreamPublisher<TS>::accept_loop, this);
+    }
+
+    //! @brief disconnects the subscribers
+    ~StreamPublisher()
+    {
+        stop_ = true;
+        internal::shutdown_socket(listen_fd_);
+        accept_thread_.join();
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            for (Connection& connection : connections_)
+            {
+                if (!connection.finished)
+                {
+                    internal::shutdown_socket(connection.fd);
+                }
+            }
+        }
+        for (Connection& connection : connections_)
+        {
+            connection.thread.join();
+        }
+        internal::close_socket(listen_fd_);
+    }
+
+    StreamPublisher(const StreamPublisher&) = delete;
+    StreamPublisher& operator=(const StreamPublisher&) = delete;
+
+    //! @brief port listened on (TCP endpoints)
+    int port() const
+    {
+        return port_;
+    }
+
+    //! @brief number of elements sent (over all connections)
+    std::size_t sent() const
+    {
+        return sent_.load();
+    }
+
+    /**
+     * @brief number of elements skipped (over all connections) because
+     * they were dropped from the time series before being sent
+     */
+    std::size_t skipped() const
+    {
+        return skipped_.load();
+    }
+
+    //! @brief number of connected subscribers
+    std::size_t connections() const
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        return std::count_if(
+            connections_.begin(),
+            connections_.end(),
+            [](const Connection& connection) { return !connection.finished; });
+    }
+
+private:
+    struct Connection
+    {
+        int fd;
+        std::thread thread;
+        // set (under mutex_) by the thread once it closed the socket
+        bool finished = false;
+    };
+
+    void accept_loop()
+    {
+        while (!stop_)
+        {
+            int fd = internal::accept_connection(listen_fd_);
+            if (fd < 0)
+            {
+                return;
+            }
+            std::lock_guard<std::mutex> guard(mutex_);
+            if (stop_)
+            {
+                internal::close_socket(fd);
+                return;
+            }
+            // joining the threads of the subscribers which disconnected
+            for (auto it = connections_.begin(); it != connections_.end();)
+            {
+                if (it->finished)
+                {
+                    it->thread.join();
+                    it = connections_.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+            connections_.emplace_back();
+            Connection& connection = connections_.back();
+            connection.fd = fd;
+            connection.thread = std::thread(
+                &StreamPublisher<TS>::stream, this, &connection);
+        }
+    }
+
+    // (connection: owned by connections_, erased only once finished)
+    void stream(Connection* connection)
+    {
+        stream_elements(connection->fd);
+        std::lock_guard<std::mutex> guard(mutex_);
+        internal::close_socket(connection->fd);
+        connection->finished = true;
+    }
+
+    // returns when the subscriber disconnected, or on stop_
+    void stream_elements(int fd)
+    {
+        // (before the handshake: once the subscriber is constructed, it
+        // gets all the elements appended from then on.
+        // EMPTY: from the first element, once the time series is not empty)
+        Index next = from_oldest_ ? time_series_.oldest_timeindex(false)
+                                  : time_series_.newest_timeindex(false);
+        if (next != EMPTY && !from_oldest_)
+        {
+            next++;
+        }
+
+        typedef internal::StreamCodec<T> Codec;
+        Codec codec;
+        std::string frame;
+        Codec::append(frame, internal::STREAM_MAGIC);
+        Codec::append(frame, internal::STREAM_VERSION);
+        Codec::append(frame, internal::type_hash<T>());
+        if (!internal::send_all(fd, frame.data(), frame.size()))
+        {
+            return;
+        }
+
+        while (!stop_)
+        {
+            Index oldest = time_series_.oldest_timeindex(false);
+            if (oldest == EMPTY)
+            {
+                if (internal::peer_closed(fd))
+                {
+                    return;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+            if (next == EMPTY)
+            {
+                next = oldest;
+            }
+            if (next < oldest)
+            {
+                skipped_ += oldest - next;
+                next = oldest;
+            }
+            bool available;
+            try
+            {
+                // (timeout, so that stop_ gets checked)
+                available = time_series_.wait_for_timeindex(next, 0.1);
+            }
+            catch (const std::invalid_argument&)
+            {
+                // dropped meanwhile
+                continue;
+            }
+            if (!available)
+            {
+                // (the subscribers never send data: checking only
+                // while idle)
+                if (internal::peer_closed(fd))
+                {
+                    return;
+                }
+                continue;
+            }
+            Index last = std::min<Index>(time_series_.newest_timeindex(false),
+                                         next + max_batch_ - 1);
+            std::vector<Sample<T>> samples;
+            try
+            {
+                // (single critical section for the batch)
+                samples = time_series_.samples(next, last);
+            }
+            catch (const std::invalid_argument&)
+            {
+                // dropped meanwhile: resync on the next iteration
+                continue;
+            }
+            frame.clear();
+            Codec::append(frame, internal::FRAME_MAGIC);
+            Codec::append(frame, static_cast<std::uint32_t>(samples.size()));
+            for (const Sample<T>& sample : samples)
+            {
+                Codec::append(frame, static_cast<std::int64_t>(sample.index));
+                Codec::append(frame, static_cast<double>(sample.timestamp));
+                codec.encode(sample.element, frame);
+            }
+            next = last + 1;
+            if (!internal::send_all(fd, frame.data(), frame.size()))
+            {
+                // subscriber disconnected
+                return;
+            }
+            sent_ += samples.size();
+        }
+    }
+
+    TS& time_series_;
+    std::size_t max_batch_;
+    bool from_oldest_;
+    std::atomic<bool> stop_;
+    std::atomic<std::size_t> sent_;
+    std::atomic<std::size_t> skipped_;
+    int listen_fd_;
+    int port_;
+    mutable std::mutex mutex_;
+    std::list<Connection> connections_;
+    std::thread accept_thread_;
+};
+
+/**
+ * @brief Appends the elements received from a StreamPublisher to a
+ * local time series (see the top of this file). The local time series
+ * uses its own indexes and timestamps; the indexes and timestamps of the
+ * publisher are available via last_index and last_timestamp_ms.
+ */
+template <typename T>
+class StreamSubscriber
+{
+public:
+    /**
+     * @param time_series the local time series to append to, which
+     * should outlive the subscriber
+     * @param endpoint the endpoint of the publisher
+     * @throws std::runtime_error if the connection fails, or if the
+     * publisher streams another element type.
+     */
+    StreamSubscriber(TimeSeriesInterface<T>& time_series,
+                     const StreamEndpoint& endpoint)
+        : time_series_(time_series),
+          connected_(true),
+          stop_(false),
+          received_(0),
+          missed_(0),
+          last_index_(EMPTY),
+          last_timestamp_ms_(std::nan(""))
+    {
+        fd_ = endpoint.is_unix
+                  ? internal::connect_unix(endpoint.address)
+                  : internal::connect_tcp(endpoint.address, endpoint.port);
+        std::uint32_t magic = 0, version = 0;
+        std::uint64_t hash = 0;
+        if (!internal::receive_all(fd_, &magic, sizeof(magic)) ||
+            !internal::receive_all(fd_, &version, sizeof(version)) ||
+            !internal::receive_all(fd_, &hash, sizeof(hash)) ||
+            magic != internal::STREAM_MAGIC ||
+            version != internal::STREAM_VERSION)
+        {
+            internal::close_socket(fd_);
+            throw std::runtime_error(
+                "stream bridge: invalid handshake from the publisher");
+        }
+        if (hash != internal::type_hash<T>())
+        {
+            internal::close_socket(fd_);
+            throw std::runtime_error(
+                "stream bridge: the publisher streams another element type");
+        }
+        thread_ = std::thread(&StreamSubscriber<T>::receive_loop, this);
+    }
+
+    //! @brief disconnects from the publisher
+    ~StreamSubscriber()
+    {
+        stop_ = true;
+        internal::shutdown_socket(fd_);
+        thread_.join();
+        internal::close_socket(fd_);
+    }
+
+    StreamSubscriber(const StreamSubscriber&) = delete;
+    StreamSubscriber& operator=(const StreamSubscriber&) = delete;
+
+    //! @brief false once the publisher closed the connection (or the
+    //! connection was closed on an error, see error)
+    bool connected() const
+    {
+        return connected_.load();
+    }
+
+    /**
+     * @brief error which closed the connection (invalid frame, invalid
+     * element size, failed deserialization), empty if none (e.g. after
+     * the publisher closed the connection)
+     */
+    std::string error() const
+    {
+        std::lock_guard<std::mutex> guard(error_mutex_);
+        return error_;
+    }
+
+    //! @brief number of elements received (and appended)
+    std::size_t received() const
+    {
+        return received_.load();
+    }
+
+    /**
+     * @brief number of elements of the publisher's time series missed
+     * (i.e. dropped before being sent), detected as gaps in the indexes
+     */
+    std::size_t missed() const
+    {
+        return missed_.load();
+    }
+
+    //! @brief index (in the publisher's time series) of the last element
+    //! received (EMPTY if none)
+    Index last_index() const
+    {
+        return last_index_.load();
+    }
+
+    //! @brief timestamp (in the publisher's time series) of the last
+    //! element received (NaN if none)
+    double last_timestamp_ms() const
+    {
+        return last_timestamp_ms_.load();
+    }
+
+private:
+    void receive_loop()
+    {
+        internal::StreamCodec<T> codec;
+        std::string bytes;
+        T element;
+        while (!stop_)
+        {
+            std::uint32_t magic, nb_elements;
+            if (!internal::receive_all(fd_, &magic, sizeof(magic)))
+            {
+                break;
+            }
+            if (magic != internal::FRAME_MAGIC)
+            {
+                fail("stream bridge: invalid frame (unexpected magic)");
+                return;
+            }
+            if (!internal::receive_all(fd_, &nb_elements, sizeof(nb_elements)))
+            {
+                break;
+            }
+            for (std::uint32_t i = 0; i < nb_elements; i++)
+            {
+                std::int64_t index;
+                double timestamp;
+                std::uint32_t size;
+                if (!internal::receive_all(fd_, &index, sizeof(index)) ||
+                    !internal::receive_all(fd_, &timestamp, sizeof(timestamp)) ||
+                    !internal::receive_all(fd_, &size, sizeof(size)))
+                {
+                    connected_ = false;
+                    return;
+                }
+                // (size sent by the peer: checked before allocating)
+                if (size > internal::StreamCodec<T>::max_size())
+                {
+                    fail("stream bridge: invalid element size " +
+                         std::to_string(size));
+                    return;
+                }
+                bytes.resize(size);
+                if (!internal::receive_all(fd_, &bytes[0], size))
+                {
+                    connected_ = false;
+                    return;
+                }
+                try
+                {
+                    codec.decode(bytes, element);
+                }
+                catch (const std::exception& e)
+                {
+                    fail(e.what());
+                    return;
+                }
+                time_series_.append(element);
+                Index previous = last_index_.load();
+                if (previous != EMPTY && index > previous + 1)
+                {
+                    missed_ += index - previous - 1;
+                }
+                last_index_ = index;
+                last_timestamp_ms_ = timestamp;
+                received_++;
+            }
+        }
+        connected_ = false;
+    }
+
+    // closes the connection (the socket being closed by the destructor)
+    void fail(const std::string& error)
+    {
+        {
+            std::lock_guard<std::mutex> guard(error_mutex_);
+            error_ = error;
+        }
+        internal::shutdown_socket(fd_);
+        connected_ = false;
+    }
+
+    TimeSeriesInterface<T>& time_series_;
+    int fd_;
+    std::atomic<bool> connected_;
+    std::atomic<bool> stop_;
+    std::atomic<std::size_t> received_;
+    std::atomic<std::size_t> missed_;
+    std::atomic<Index> last_index_;
+    std::atomic<double> last_timestamp_ms_;
+    mutable std::mutex error_mutex_;
+    std::string error_;
+    std::thread thread_;
+};
+
+}  // namespace time_series
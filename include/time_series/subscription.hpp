@@ -0,0 +1,84 @@
+/**
+ * @file subscription.hpp
+ * license License BSD-3-Clause
+ * @copyright Copyright (c) 2019, Max Planck Gesellschaft.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include "time_series/internal/subscribers.hpp"
+
+namespace time_series
+{
+/**
+ * @brief Handle on a callback subscribed to a time series (see
+ * TimeSeries::subscribe). The subscription is cancelled when the handle
+ * is destroyed.
+ */
+class Subscription
+{
+public:
+    Subscription()
+    {
+    }
+
+    Subscription(std::shared_ptr<internal::SubscriberBase> subscriber)
+        : subscriber_(std::move(subscriber))
+    {
+    }
+
+    Subscription(Subscription&& other) noexcept = default;
+    Subscription& operator=(Subscription&& other) noexcept
+    {
+        cancel();
+        subscriber_ = std::move(other.subscriber_);
+        return *this;
+    }
+
+    ~Subscription()
+    {
+        cancel();
+    }
+
+    /**
+     * @brief No more samples are delivered once this returns: queued
+     * samples are discarded, and a running callback is waited for
+     * (cancel should therefore not be called from the callback).
+     */
+    void cancel()
+    {
+        if (subscriber_)
+        {
+            subscriber_->cancel();
+        }
+    }
+
+    //! @brief number of samples delivered to the callback
+    std::size_t delivered() const
+    {
+        return subscriber_ ? subscriber_->delivered() : 0;
+    }
+
+    /**
+     * @brief number of samples dropped because the backlog was full
+     * (i.e. the callback did not keep up with the appends)
+     */
+    std::size_t dropped() const
+    {
+        return subscriber_ ? subscriber_->dropped() : 0;
+    }
+
+    //! @brief number of samples queued, not delivered yet
+    std::size_t backlog() const
+    {
+        return subscriber_ ? subscriber_->backlog() : 0;
+    }
+
+private:
+    std::shared_ptr<internal::SubscriberBase> subscriber_;
+};
+
+}  // namespace time_series
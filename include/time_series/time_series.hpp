@@ -7,8 +7,16 @@
 
 #pragma once
 
+#include <algorithm>
 #include <chrono>
+#include <atomic>
 #include <cmath>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 #include "real_time_tools/timer.hpp"
 
@@ -21,6 +29,15 @@
 // multiprocesses TimeSeries
 #include "time_series/internal/base.hpp"
 
+// callbacks waiting for new elements (see when_available)
+#include "time_series/internal/async_waiters.hpp"
+
+// file descriptor signaled on new elements (see event_fd)
+#include "time_series/internal/event_fd.hpp"
+
+// callbacks run on an executor for each new element (see subscribe)
+#include "time_series/subscription.hpp"
+
 // Mutex, ConditionVariable, Lock and Vector
 // use different implementation for TimeSeries and
 // MultiprocessesTimeSeries. Those are defined there.
@@ -30,34 +47,251 @@ namespace time_series
 {
 /**
  * @brief Threadsafe time series
+ *
+ * @tparam Policies clock, wait, capacity and period statistics policies
+ *     (see policies.hpp)
  */
-template <typename T = int>
-class TimeSeries : public internal::TimeSeriesBase<internal::SingleProcess, T>
+template <typename T = int, typename Policies = DefaultPolicies>
+class TimeSeries
+    : public internal::TimeSeriesBase<internal::SingleProcess, T, Policies>
 {
+    typedef internal::TimeSeriesBase<internal::SingleProcess, T, Policies>
+        Base;
+
 public:
+    /**
+     * @param max_length max number of elements in the time series
+     * @param start_timeindex time index of the first element
+     * @param throw_on_sigint if true, a signal_handler::ReceivedSignal
+     *     exception is thrown when a SIGINT signal is received while waiting
+     * @param page_backing pages requested for the storage of the elements,
+     *     see memory_options.hpp and page_backing()
+     * @param memory_commit when the storage memory should be committed,
+     *     see memory_options.hpp and memory_commit()
+     * @param lock_protocol protocol of the mutex, e.g. priority inheritance
+     *     for time series shared by real time and lower priority threads,
+     *     see lock_options.hpp
+     * @throws std::invalid_argument if max_length does not match a
+     *     FixedCapacity policy
+     * @throws std::runtime_error if the lock protocol is not supported
+     */
     TimeSeries(size_t max_length,
                Index start_timeindex = 0,
-               bool throw_on_sigint = true)
-        : internal::TimeSeriesBase<internal::SingleProcess, T>(start_timeindex,
-                                                               throw_on_sigint)
+               bool throw_on_sigint = true,
+               PageBacking page_backing = PageBacking::DEFAULT_PAGES,
+               MemoryCommit memory_commit = MemoryCommit::DEFAULT,
+               LockProtocol lock_protocol = LockProtocol::DEFAULT)
+        : Base(start_timeindex, throw_on_sigint)
     {
+        Base::checked_max_length(max_length);
         this->mutex_ptr_ =
-            std::make_shared<internal::Mutex<internal::SingleProcess> >();
+            std::make_shared<internal::Mutex<internal::SingleProcess> >(
+                lock_protocol);
         this->condition_ptr_ = std::make_shared<
-            internal::ConditionVariable<internal::SingleProcess> >();
+            internal::ConditionVariable<internal::SingleProcess> >(
+            lock_protocol);
         this->history_elements_ptr_ =
             std::make_shared<internal::Vector<internal::SingleProcess, T> >(
-                max_length);
-        this->history_timestamps_ptr_ = std::make_shared<
-            internal::Vector<internal::SingleProcess, Timestamp> >(max_length);
+                max_length, page_backing, memory_commit);
+        if constexpr (Policies::clock::timestamps)
+        {
+            this->history_timestamps_ptr_ = std::make_shared<
+                internal::Vector<internal::SingleProcess, Timestamp> >(
+                max_length, PageBacking::DEFAULT_PAGES, memory_commit);
+        }
+        this->indexes_ptr_ =
+            std::make_shared<internal::Indexes>(start_timeindex);
+        if constexpr (Policies::period::enabled)
+        {
+            this->period_tracker_ptr_ =
+                std::make_shared<internal::PeriodTracker>();
+        }
+        async_waiters_ptr_ = std::make_shared<internal::AsyncWaiters>();
+        event_fd_ptr_ = std::make_shared<internal::EventFd>();
+        subscribers_ptr_ = std::make_shared<internal::Subscribers<T> >();
+    }
+
+    /**
+     * @brief Appends the element, then queues it for the subscribers (see
+     * subscribe), calls the callbacks registered via when_available that
+     * were waiting for it, and signals the event file descriptor (if
+     * event_fd has been called).
+     */
+    void append(const T &element)
+    {
+        if (subscribers_ptr_->size() > 0)
+        {
+            std::lock_guard<std::mutex> guard(subscribers_ptr_->mutex());
+            Timestamp timestamp;
+            Index index = Base::append_element(element, timestamp);
+            subscribers_ptr_->publish(Sample<T>{index, element, timestamp});
+        }
+        else
+        {
+            Base::append(element);
+        }
+        event_fd_ptr_->notify();
+        // pairs with the fence of when_available: either when_available
+        // sees the new element, or append sees the callback
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (async_waiters_ptr_->size() > 0)
+        {
+            async_waiters_ptr_->dispatch(this->newest_timeindex(false));
+        }
+    }
+
+    /**
+     * @brief Registers a callback to be called once the element of index
+     * timeindex has been appended, without blocking the calling thread
+     * (used by the coroutine awaitables of coroutines.hpp).
+     * The callback is called by the thread calling append (or
+     * by this call, if the element gets appended concurrently). It should
+     * be short, e.g. posting the actual work to an executor.
+     * @returns false (and the callback is not registered) if the element
+     * has already been appended.
+     */
+    bool when_available(const Index &timeindex,
+                        std::function<void()> callback)
+    {
+        if (this->newest_timeindex(false) >= timeindex)
+        {
+            return false;
+        }
+        async_waiters_ptr_->add(timeindex, std::move(callback));
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        Index newest = this->newest_timeindex(false);
+        if (newest >= timeindex)
+        {
+            // appended meanwhile, the callback may have been missed
+            async_waiters_ptr_->dispatch(newest);
+        }
+        return true;
     }
 
-protected:
-    void read_indexes() const
+    /**
+     * @brief Calls f(const T* elements, std::size_t nb_elements) on the
+     * (one or two, as the storage is circular) contiguous chunks of memory
+     * containing the elements from first to last (included), in order.
+     * Waits if last is not yet in the time series.
+     * The storage is aligned on cache lines (and on alignof(T)), so the
+     * chunks may be mapped directly by vectorized code (e.g. Eigen::Map)
+     * without copy.
+     * f is called while the time series is locked: it should not call any
+     * method of this time series, and the pointers should not be used after
+     * f returns.
+     * @throws std::invalid_argument if first is older than the oldest
+     * element, or if last is smaller than first.
+     */
+    template <typename F>
+    void visit_range(const Index &first, const Index &last, F f) const
     {
+        internal::Lock<internal::SingleProcess> lock(*this->mutex_ptr_);
+        this->read_indexes();
+        if (last < first)
+        {
+            throw std::invalid_argument("visit_range: invalid range " +
+                                        std::to_string(first) + " to " +
+                                        std::to_string(last));
+        }
+        while (this->newest_timeindex_ < last)
+        {
+            this->throw_if_sigint_received();
+            this->wait_on_condition(lock);
+            this->read_indexes();
+        }
+        if (first < this->oldest_timeindex_)
+        {
+            throw std::invalid_argument(
+                "you tried to access time_series element " +
+                std::to_string(first) +
+                " which is too old (oldest in buffer is " +
+                std::to_string(this->oldest_timeindex_) + ").");
+        }
+        const T *data = this->history_elements_ptr_->data();
+        std::size_t size = this->max_length();
+        std::size_t start = this->slot(first);
+        std::size_t nb_elements = last - first + 1;
+        std::size_t first_chunk = std::min(nb_elements, size - start);
+        f(data + start, first_chunk);
+        if (first_chunk < nb_elements)
+        {
+            f(data, nb_elements - first_chunk);
+        }
     }
-    void write_indexes()
+
+    /**
+     * @brief Returns a file descriptor (eventfd) which becomes readable
+     * when elements get appended, e.g. for adding the time series to an
+     * epoll / poll / select event loop. Once readable, the fd should be
+     * read (8 bytes, non blocking) to reset it, before checking for the
+     * new elements (e.g. via newest_timeindex(false)).
+     * The fd is created on the first call (appends before that do not
+     * signal anything) and closed when the time series is destroyed.
+     * For time series appended by another process, see
+     * Reactor::event_fd.
+     * @throws std::runtime_error if the eventfd can not be created.
+     */
+    int event_fd()
+    {
+        return event_fd_ptr_->get();
+    }
+
+    /**
+     * @brief Subscribes the callback, which gets called (via the executor,
+     * e.g. WorkerPool::executor()) with each element appended from now on.
+     * append only queues the element: the callback is never run by the
+     * thread calling append (unless the executor runs tasks inline).
+     * The callback of a subscription is never called concurrently, and
+     * gets the elements in order. If it does not keep up, up to
+     * max_backlog elements are queued, older elements being dropped (see
+     * Subscription::dropped).
+     * Subscribers slow down append (which then copies the element for each
+     * subscriber) and serialize concurrent appends.
+     * @returns the handle of the subscription, which is cancelled when
+     * the handle is destroyed.
+     * @throws std::invalid_argument if max_backlog is 0.
+     */
+    Subscription subscribe(
+        std::function<void(const Sample<T> &)> callback,
+        typename internal::Subscriber<T>::Executor executor,
+        std::size_t max_backlog = 1024)
     {
+        return subscribe_batch(
+            [callback](const std::vector<Sample<T> > &samples) {
+                for (const Sample<T> &sample : samples)
+                {
+                    callback(sample);
+                }
+            },
+            std::move(executor),
+            max_backlog);
     }
+
+    /**
+     * @brief Same as subscribe, the callback getting all the elements
+     * queued since its previous call (coalesced batch, in order).
+     */
+    Subscription subscribe_batch(
+        std::function<void(const std::vector<Sample<T> > &)> callback,
+        typename internal::Subscriber<T>::Executor executor,
+        std::size_t max_backlog = 1024)
+    {
+        if (max_backlog == 0)
+        {
+            throw std::invalid_argument(
+                "subscribe: max backlog should be positive");
+        }
+        std::shared_ptr<internal::Subscriber<T> > subscriber =
+            std::make_shared<internal::Subscriber<T> >(
+                std::move(callback), std::move(executor), max_backlog);
+        subscribers_ptr_->add(subscriber);
+        return Subscription(subscriber);
+    }
+
+private:
+    // (shared_ptr, so that the time series remains movable)
+    std::shared_ptr<internal::AsyncWaiters> async_waiters_ptr_;
+    std::shared_ptr<internal::EventFd> event_fd_ptr_;
+    std::shared_ptr<internal::Subscribers<T> > subscribers_ptr_;
 };
 }  // namespace time_series
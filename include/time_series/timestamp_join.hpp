@@ -0,0 +1,370 @@
+/**
+ * @file timestamp_join.hpp
+ * license License BSD-3-Clause
+ * @copyright Copyright (c) 2019, Max Planck Gesellschaft.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <deque>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "time_series/interface.hpp"
+
+namespace time_series
+{
+/**
+ * How the elements of a secondary time series are matched to an element
+ * of the primary time series of timestamp t (see TimestampJoin):
+ */
+enum class JoinMethod
+{
+    //! nearest element (before or after t), with |timestamp - t| <=
+    //! tolerance. An element may be matched to several primary elements.
+    NEAREST,
+    //! newest element with timestamp <= t (zero order hold), with
+    //! t - timestamp <= tolerance
+    PREVIOUS,
+    //! nearest element with |timestamp - t| <= tolerance, each element
+    //! being matched at most once (one to one pairing)
+    EXACT
+};
+
+/**
+ * @brief Aligns the elements of several time series on their timestamps:
+ * for each element of the primary time series (in order), the matching
+ * element of each secondary time series is selected according to the
+ * method (see JoinMethod), yielding tuples (std::tuple of Sample).
+ * Primary elements for which a secondary time series has no match are
+ * skipped (see unmatched()).
+ *
+ * poll() is incremental: the elements appended since the previous call are
+ * read in bulk (see TimeSeriesBase::samples), in chunks of at most
+ * FETCH_CHUNK elements so that the writers are not blocked for the copy of
+ * a whole backlog, and the tuples which can be decided are returned. A tuple is decided once the secondary time series have
+ * elements newer than the primary element (i.e. a tuple is delayed until
+ * slower time series catch up).
+ *
+ * The elements buffered while waiting for slower time series are capped,
+ * for each time series, to its max length: if a time series stalls, the
+ * oldest elements of the others are dropped (see dropped()).
+ *
+ * The time series (TimeSeries or MultiprocessTimeSeries, with timestamps)
+ * should outlive the join, and have monotonic timestamps. The join starts
+ * from the oldest elements of the time series at the first call to poll.
+ * Not thread safe (to be polled by a single thread).
+ */
+template <typename Primary, typename... Secondaries>
+class TimestampJoin
+{
+    template <typename TS>
+    using ElementOf = typename std::decay<decltype(
+        std::declval<const TS&>().at(Index()).element)>::type;
+
+public:
+    //! max number of elements copied per critical section by poll()
+    static constexpr std::size_t FETCH_CHUNK = 1024;
+
+    typedef std::tuple<Sample<ElementOf<Primary>>,
+                       Sample<ElementOf<Secondaries>>...>
+        Tuple;
+
+    /**
+     * @param method how secondary elements are matched
+     * @param tolerance_ms max difference between the timestamps of matched
+     * elements (may be infinite for NEAREST and PREVIOUS)
+     * @param primary the time series driving the join
+     * @param secondaries the time series aligned on the primary one
+     * @throws std::invalid_argument if tolerance_ms is negative (or
+     * infinite, for EXACT).
+     */
+    TimestampJoin(JoinMethod method,
+                  double tolerance_ms,
+                  const Primary& primary,
+                  const Secondaries&... secondaries)
+        : method_(method),
+          tolerance_ms_(tolerance_ms),
+          series_(&primary, &secondaries...),
+          unmatched_(0),
+          dropped_(0)
+    {
+        static_assert(sizeof...(Secondaries) > 0,
+                      "TimestampJoin: at least one secondary time series");
+        if (!(tolerance_ms >= 0) ||
+            (method == JoinMethod::EXACT && std::isinf(tolerance_ms)))
+        {
+            throw std::invalid_argument(
+                "TimestampJoin: invalid tolerance " +
+                std::to_string(tolerance_ms));
+        }
+    }
+
+    //! @brief returns the tuples decided since the previous call
+    std::vector<Tuple> poll()
+    {
+        fetch_all(std::index_sequence_for<Primary, Secondaries...>());
+        std::vector<Tuple> tuples;
+        auto& primary = std::get<0>(cursors_).buffer;
+        while (!primary.empty())
+        {
+            if (!align(primary.front(),
+                       tuples,
+                       std::index_sequence_for<Secondaries...>()))
+            {
+                break;
+            }
+            primary.pop_front();
+        }
+        return tuples;
+    }
+
+    //! @brief number of primary elements skipped for lack of a match
+    std::size_t unmatched() const
+    {
+        return unmatched_;
+    }
+
+    /**
+     * @brief number of elements (of all the time series) never aligned
+     * because they were dropped, either from their time series before
+     * being polled, or from the buffer of the join (see above)
+     */
+    std::size_t dropped() const
+    {
+        return dropped_;
+    }
+
+private:
+    template <typename T>
+    struct Cursor
+    {
+        Cursor() : next(EMPTY)
+        {
+        }
+        // next index to read (EMPTY: from the oldest one)
+        Index next;
+        std::deque<Sample<T>> buffer;
+    };
+
+    enum class Decision
+    {
+        NOT_READY,
+        NO_MATCH,
+        MATCH
+    };
+
+    // reads in bulk the elements appended since the previous call, at most
+    // FETCH_CHUNK per critical section
+    template <typename TS, typename T>
+    void fetch(const TS& ts, Cursor<T>& cursor)
+    {
+        Index newest = ts.newest_timeindex(false);
+        if (newest == EMPTY)
+        {
+            return;
+        }
+        while (true)
+        {
+            Index oldest = ts.oldest_timeindex(false);
+            Index first = cursor.next == EMPTY || cursor.next < oldest
+                              ? oldest
+                              : cursor.next;
+            if (first > newest)
+            {
+                return;
+            }
+            Index last = std::min(
+                newest, first + static_cast<Index>(FETCH_CHUNK) - 1);
+            std::vector<Sample<T>> samples;
+            try
+            {
+                samples = ts.samples(first, last);
+            }
+            catch (const std::invalid_argument&)
+            {
+                // first dropped meanwhile
+                continue;
+            }
+            if (cursor.next != EMPTY)
+            {
+                dropped_ += first - cursor.next;
+            }
+            cursor.buffer.insert(
+                cursor.buffer.end(), samples.begin(), samples.end());
+            cursor.next = last + 1;
+            while (cursor.buffer.size() > ts.max_length())
+            {
+                cursor.buffer.pop_front();
+                dropped_++;
+            }
+        }
+    }
+
+    template <std::size_t... I>
+    void fetch_all(std::index_sequence<I...>)
+    {
+        (fetch(*std::get<I>(series_), std::get<I>(cursors_)), ...);
+    }
+
+    // selects (as position in the buffer) the element matching timestamp t
+    template <typename T>
+    Decision decide(std::deque<Sample<T>>& buffer,
+                    Timestamp t,
+                    std::size_t& position) const
+    {
+        Timestamp tolerance = tolerance_ms_;
+        if (method_ == JoinMethod::EXACT)
+        {
+            // (too old for t, hence for the next primary elements)
+            while (!buffer.empty() && buffer.front().timestamp < t - tolerance)
+            {
+                buffer.pop_front();
+            }
+            if (buffer.empty())
+            {
+                return Decision::NOT_READY;
+            }
+            if (buffer.front().timestamp > t + tolerance)
+            {
+                return Decision::NO_MATCH;
+            }
+            position = 0;
+            bool complete = false;
+            for (std::size_t i = 0; i < buffer.size(); i++)
+            {
+                if (buffer[i].timestamp > t + tolerance)
+                {
+                    complete = true;
+                    break;
+                }
+                if (std::abs(buffer[i].timestamp - t) <
+                    std::abs(buffer[position].timestamp - t))
+                {
+                    position = i;
+                }
+            }
+            // (an element appended later may be nearer, unless exact)
+            if (!complete && buffer[position].timestamp != t)
+            {
+                return Decision::NOT_READY;
+            }
+            return Decision::MATCH;
+        }
+
+        // (dominated by the next element for t, hence for the next
+        // primary elements)
+        while (buffer.size() >= 2 && buffer[1].timestamp <= t)
+        {
+            buffer.pop_front();
+        }
+        if (buffer.empty())
+        {
+            return Decision::NOT_READY;
+        }
+        const Timestamp first = buffer[0].timestamp;
+        if (method_ == JoinMethod::PREVIOUS)
+        {
+            if (first > t)
+            {
+                return Decision::NO_MATCH;
+            }
+            if (first < t && buffer.size() < 2)
+            {
+                // an element appended later may be newer and <= t
+                return Decision::NOT_READY;
+            }
+            position = 0;
+            return t - first <= tolerance ? Decision::MATCH
+                                          : Decision::NO_MATCH;
+        }
+        // NEAREST
+        if (first >= t)
+        {
+            position = 0;
+        }
+        else if (buffer.size() >= 2)
+        {
+            position = buffer[1].timestamp - t < t - first ? 1 : 0;
+        }
+        else
+        {
+            // an element appended later may be nearer
+            return Decision::NOT_READY;
+        }
+        return std::abs(buffer[position].timestamp - t) <= tolerance
+                   ? Decision::MATCH
+                   : Decision::NO_MATCH;
+    }
+
+    // appends the tuple of the primary element (or counts it as
+    // unmatched). Returns false if not all secondaries can decide yet.
+    template <std::size_t... I>
+    bool align(const Sample<ElementOf<Primary>>& primary,
+               std::vector<Tuple>& tuples,
+               std::index_sequence<I...>)
+    {
+        std::array<std::size_t, sizeof...(I)> positions{};
+        std::array<Decision, sizeof...(I)> decisions{
+            {decide(std::get<I + 1>(cursors_).buffer,
+                    primary.timestamp,
+                    positions[I])...}};
+        for (Decision decision : decisions)
+        {
+            if (decision == Decision::NOT_READY)
+            {
+                return false;
+            }
+        }
+        for (Decision decision : decisions)
+        {
+            if (decision == Decision::NO_MATCH)
+            {
+                unmatched_++;
+                return true;
+            }
+        }
+        tuples.emplace_back(
+            primary, std::get<I + 1>(cursors_).buffer[positions[I]]...);
+        if (method_ == JoinMethod::EXACT)
+        {
+            (std::get<I + 1>(cursors_).buffer.erase(
+                 std::get<I + 1>(cursors_).buffer.begin() + positions[I]),
+             ...);
+        }
+        return true;
+    }
+
+    JoinMethod method_;
+    double tolerance_ms_;
+    std::tuple<const Primary*, const Secondaries*...> series_;
+    std::tuple<Cursor<ElementOf<Primary>>, Cursor<ElementOf<Secondaries>>...>
+        cursors_;
+    std::size_t unmatched_;
+    std::size_t dropped_;
+};
+
+/**
+ * @brief returns a TimestampJoin of the time series
+ * (see the TimestampJoin constructor for the arguments)
+ */
+template <typename Primary, typename... Secondaries>
+TimestampJoin<Primary, Secondaries...> make_timestamp_join(
+    JoinMethod method,
+    double tolerance_ms,
+    const Primary& primary,
+    const Secondaries&... secondaries)
+{
+    return TimestampJoin<Primary, Secondaries...>(
+        method, tolerance_ms, primary, secondaries...);
+}
+
+}  // namespace time_series
@@ -0,0 +1,60 @@
+/**
+ * @file worker_pool.hpp
+ * license License BSD-3-Clause
+ * @copyright Copyright (c) 2019, Max Planck Gesellschaft.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace time_series
+{
+/**
+ * @brief Fixed number of threads running posted tasks, in the order in
+ * which they were posted. May be shared by any number of subscriptions
+ * (see TimeSeries::subscribe).
+ */
+class WorkerPool
+{
+public:
+    typedef std::function<void(std::function<void()>)> Executor;
+
+    /**
+     * @param nb_threads number of worker threads (if 0: the number of
+     * hardware threads)
+     */
+    WorkerPool(std::size_t nb_threads = 0);
+
+    //! @brief waits for the running tasks, tasks still queued are discarded
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    //! @brief queues the task, to be run by one of the worker threads
+    void post(std::function<void()> task);
+
+    //! @brief executor posting to this pool (which should outlive it)
+    Executor executor();
+
+    //! @brief number of worker threads
+    std::size_t size() const;
+
+private:
+    void run();
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<std::function<void()>> tasks_;
+    bool stop_;
+    std::vector<std::thread> threads_;
+};
+
+}  // namespace time_series
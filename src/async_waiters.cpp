@@ -0,0 +1,47 @@
+#include "time_series/internal/async_waiters.hpp"
+
+#include <utility>
+#include <vector>
+
+namespace time_series
+{
+namespace internal
+{
+AsyncWaiters::AsyncWaiters() : size_(0)
+{
+}
+
+void AsyncWaiters::add(Index timeindex, std::function<void()> callback)
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    callbacks_.emplace(timeindex, std::move(callback));
+    size_.fetch_add(1, std::memory_order_seq_cst);
+}
+
+void AsyncWaiters::dispatch(Index newest)
+{
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        auto end = callbacks_.upper_bound(newest);
+        for (auto it = callbacks_.begin(); it != end; ++it)
+        {
+            ready.push_back(std::move(it->second));
+        }
+        callbacks_.erase(callbacks_.begin(), end);
+        size_.fetch_sub(ready.size(), std::memory_order_seq_cst);
+    }
+    // (callbacks may resume coroutines, which may register again)
+    for (std::function<void()>& callback : ready)
+    {
+        callback();
+    }
+}
+
+std::size_t AsyncWaiters::size() const
+{
+    return size_.load(std::memory_order_seq_cst);
+}
+
+}  // namespace internal
+}  // namespace time_series
@@ -0,0 +1,264 @@
+#include "time_series/internal/compression.hpp"
+
+namespace time_series
+{
+namespace internal
+{
+static std::uint64_t mask(int nb_bits)
+{
+    return nb_bits >= 64 ? ~std::uint64_t(0)
+                         : (std::uint64_t(1) << nb_bits) - 1;
+}
+
+// maps signed integers to unsigned ones, small absolute values
+// to small values (0, -1, 1, -2, ... to 0, 1, 2, 3, ...)
+static std::uint64_t zigzag(std::int64_t value)
+{
+    return (static_cast<std::uint64_t>(value) << 1) ^
+           static_cast<std::uint64_t>(value >> 63);
+}
+
+static std::int64_t unzigzag(std::uint64_t value)
+{
+    return static_cast<std::int64_t>(value >> 1) ^
+           -static_cast<std::int64_t>(value & 1);
+}
+
+// ------- bits ------- //
+
+BitWriter::BitWriter(Bits &bits) : bits_(bits), used_(0)
+{
+    bits_.clear();
+}
+
+void BitWriter::clear()
+{
+    bits_.clear();
+    used_ = 0;
+}
+
+void BitWriter::write(std::uint64_t value, int nb_bits)
+{
+    value &= mask(nb_bits);
+    while (nb_bits > 0)
+    {
+        if (used_ == 0)
+        {
+            bits_.push_back(0);
+        }
+        int available = 64 - used_;
+        int nb = nb_bits < available ? nb_bits : available;
+        // most significant bits first
+        std::uint64_t chunk = (value >> (nb_bits - nb)) & mask(nb);
+        bits_.back() |= chunk << (available - nb);
+        used_ = (used_ + nb) % 64;
+        nb_bits -= nb;
+    }
+}
+
+std::size_t BitWriter::size() const
+{
+    return bits_.empty() ? 0 : (bits_.size() - 1) * 64 + (used_ ? used_ : 64);
+}
+
+BitReader::BitReader(const Bits &bits) : bits_(bits), position_(0)
+{
+}
+
+std::uint64_t BitReader::read(int nb_bits)
+{
+    std::uint64_t value = 0;
+    while (nb_bits > 0)
+    {
+        int offset = position_ % 64;
+        int available = 64 - offset;
+        int nb = nb_bits < available ? nb_bits : available;
+        std::uint64_t chunk =
+            (bits_[position_ / 64] >> (available - nb)) & mask(nb);
+        value = nb == 64 ? chunk : (value << nb) | chunk;
+        position_ += nb;
+        nb_bits -= nb;
+    }
+    return value;
+}
+
+// ------- delta of delta ------- //
+
+// control bits and number of bits of the (zigzag encoded) delta of delta
+// '0': 0, '10': 7 bits, '110': 9 bits, '1110': 12 bits, '1111': 64 bits
+
+DeltaOfDeltaEncoder::DeltaOfDeltaEncoder()
+{
+    reset();
+}
+
+void DeltaOfDeltaEncoder::reset()
+{
+    count_ = 0;
+    previous_ = 0;
+    delta_ = 0;
+}
+
+void DeltaOfDeltaEncoder::encode(std::int64_t value, BitWriter &writer)
+{
+    if (count_ == 0)
+    {
+        writer.write(static_cast<std::uint64_t>(value), 64);
+    }
+    else
+    {
+        std::int64_t delta = value - previous_;
+        std::uint64_t dod = zigzag(delta - delta_);
+        if (dod == 0)
+        {
+            writer.write(0, 1);
+        }
+        else if (dod < (std::uint64_t(1) << 7))
+        {
+            writer.write(0b10, 2);
+            writer.write(dod, 7);
+        }
+        else if (dod < (std::uint64_t(1) << 9))
+        {
+            writer.write(0b110, 3);
+            writer.write(dod, 9);
+        }
+        else if (dod < (std::uint64_t(1) << 12))
+        {
+            writer.write(0b1110, 4);
+            writer.write(dod, 12);
+        }
+        else
+        {
+            writer.write(0b1111, 4);
+            writer.write(dod, 64);
+        }
+        delta_ = delta;
+    }
+    previous_ = value;
+    count_++;
+}
+
+DeltaOfDeltaDecoder::DeltaOfDeltaDecoder() : count_(0), previous_(0), delta_(0)
+{
+}
+
+std::int64_t DeltaOfDeltaDecoder::decode(BitReader &reader)
+{
+    if (count_ == 0)
+    {
+        previous_ = static_cast<std::int64_t>(reader.read(64));
+    }
+    else
+    {
+        int nb_bits = 0;
+        if (reader.read(1))
+        {
+            if (!reader.read(1))
+            {
+                nb_bits = 7;
+            }
+            else if (!reader.read(1))
+            {
+                nb_bits = 9;
+            }
+            else if (!reader.read(1))
+            {
+                nb_bits = 12;
+            }
+            else
+            {
+                nb_bits = 64;
+            }
+        }
+        std::int64_t dod = nb_bits ? unzigzag(reader.read(nb_bits)) : 0;
+        delta_ += dod;
+        previous_ += delta_;
+    }
+    count_++;
+    return previous_;
+}
+
+// ------- xor ------- //
+
+// '0': same value as previous
+// '10' + meaningful bits: xor within the window of the previous xor
+// '11' + leading zeros (6 bits) + meaningful length - 1 (6 bits)
+//      + meaningful bits: new window
+
+XorEncoder::XorEncoder()
+{
+    reset();
+}
+
+void XorEncoder::reset()
+{
+    first_ = true;
+    previous_ = 0;
+    leading_ = -1;
+    trailing_ = 0;
+}
+
+void XorEncoder::encode(std::uint64_t value, BitWriter &writer)
+{
+    if (first_)
+    {
+        writer.write(value, 64);
+        first_ = false;
+        previous_ = value;
+        return;
+    }
+    std::uint64_t x = value ^ previous_;
+    previous_ = value;
+    if (x == 0)
+    {
+        writer.write(0, 1);
+        return;
+    }
+    int leading = __builtin_clzll(x);
+    int trailing = __builtin_ctzll(x);
+    if (leading_ >= 0 && leading >= leading_ && trailing >= trailing_)
+    {
+        writer.write(0b10, 2);
+        writer.write(x >> trailing_, 64 - leading_ - trailing_);
+        return;
+    }
+    int length = 64 - leading - trailing;
+    writer.write(0b11, 2);
+    writer.write(leading, 6);
+    writer.write(length - 1, 6);
+    writer.write(x >> trailing, length);
+    leading_ = leading;
+    trailing_ = trailing;
+}
+
+XorDecoder::XorDecoder()
+    : first_(true), previous_(0), leading_(0), trailing_(0)
+{
+}
+
+std::uint64_t XorDecoder::decode(BitReader &reader)
+{
+    if (first_)
+    {
+        first_ = false;
+        previous_ = reader.read(64);
+        return previous_;
+    }
+    if (!reader.read(1))
+    {
+        return previous_;
+    }
+    if (reader.read(1))
+    {
+        leading_ = static_cast<int>(reader.read(6));
+        int length = static_cast<int>(reader.read(6)) + 1;
+        trailing_ = 64 - leading_ - length;
+    }
+    std::uint64_t x = reader.read(64 - leading_ - trailing_) << trailing_;
+    previous_ ^= x;
+    return previous_;
+}
+
+}  // namespace internal
+}  // namespace time_series
@@ -0,0 +1,65 @@
+#include "time_series/internal/event_fd.hpp"
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace time_series
+{
+namespace internal
+{
+EventFd::EventFd() : fd_(-1)
+{
+}
+
+EventFd::~EventFd()
+{
+    int fd = fd_.load(std::memory_order_acquire);
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+}
+
+int EventFd::get()
+{
+    int fd = fd_.load(std::memory_order_acquire);
+    if (fd >= 0)
+    {
+        return fd;
+    }
+    std::lock_guard<std::mutex> guard(mutex_);
+    fd = fd_.load(std::memory_order_acquire);
+    if (fd < 0)
+    {
+        fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (fd < 0)
+        {
+            throw std::runtime_error(std::string("failed to create eventfd: ") +
+                                     std::strerror(errno));
+        }
+        fd_.store(fd, std::memory_order_release);
+    }
+    return fd;
+}
+
+void EventFd::notify()
+{
+    int fd = fd_.load(std::memory_order_acquire);
+    if (fd >= 0)
+    {
+        std::uint64_t one = 1;
+        // (EAGAIN only if the counter is about to overflow, in which case
+        // the file descriptor is readable anyway)
+        ssize_t written = write(fd, &one, sizeof(one));
+        (void)written;
+    }
+}
+
+}  // namespace internal
+}  // namespace time_series
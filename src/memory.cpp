@@ -0,0 +1,209 @@
+#include "time_series/internal/memory.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <new>
+#include <vector>
+
+#ifndef HUGETLBFS_MAGIC
+#define HUGETLBFS_MAGIC 0x958458f6
+#endif
+
+// (linux >= 5.14)
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+
+namespace time_series
+{
+namespace internal
+{
+static std::size_t page_size()
+{
+    static const std::size_t size = sysconf(_SC_PAGESIZE);
+    return size;
+}
+
+static void *allocate_pages(std::size_t size,
+                            std::size_t alignment,
+                            const Allocation &requested,
+                            PageBacking &obtained)
+{
+    if (requested.page_backing == PageBacking::HUGE_PAGES)
+    {
+        // fails if no huge pages are reserved (vm.nr_hugepages)
+        void *memory = mmap(nullptr,
+                            huge_page_ceil(size),
+                            PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                            -1,
+                            0);
+        if (memory != MAP_FAILED)
+        {
+            obtained = PageBacking::HUGE_PAGES;
+            return memory;
+        }
+    }
+    if (requested.page_backing != PageBacking::DEFAULT_PAGES)
+    {
+        void *memory = ::operator new(huge_page_ceil(size),
+                                      std::align_val_t(HUGE_PAGE_SIZE));
+        // fails if transparent huge pages are not supported
+        if (madvise(memory, huge_page_ceil(size), MADV_HUGEPAGE) == 0)
+        {
+            obtained = PageBacking::TRANSPARENT_HUGE_PAGES;
+            return memory;
+        }
+        ::operator delete(memory, std::align_val_t(HUGE_PAGE_SIZE));
+    }
+    obtained = PageBacking::DEFAULT_PAGES;
+    if (requested.commit == MemoryCommit::LAZY)
+    {
+        // fresh anonymous mapping: pages committed on first write
+        // (page aligned, which is enough for any alignment used here)
+        void *memory = mmap(nullptr,
+                            size,
+                            PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                            -1,
+                            0);
+        if (memory == MAP_FAILED)
+        {
+            throw std::bad_alloc();
+        }
+        return memory;
+    }
+    return ::operator new(size, std::align_val_t(alignment));
+}
+
+void *allocate_memory(std::size_t size,
+                      std::size_t alignment,
+                      const Allocation &requested,
+                      Allocation &obtained)
+{
+    void *memory =
+        allocate_pages(size, alignment, requested, obtained.page_backing);
+    obtained.commit = requested.commit;
+    if (requested.commit == MemoryCommit::PREFAULT ||
+        requested.commit == MemoryCommit::LOCK)
+    {
+        obtained.commit = prefault_memory(
+            memory, size, requested.commit == MemoryCommit::LOCK);
+    }
+    return memory;
+}
+
+void deallocate_memory(void *memory,
+                       std::size_t size,
+                       std::size_t alignment,
+                       const Allocation &obtained)
+{
+    if (obtained.commit == MemoryCommit::LOCK)
+    {
+        munlock(memory, size);
+    }
+    switch (obtained.page_backing)
+    {
+        case PageBacking::HUGE_PAGES:
+            munmap(memory, huge_page_ceil(size));
+            break;
+        case PageBacking::TRANSPARENT_HUGE_PAGES:
+            ::operator delete(memory, std::align_val_t(HUGE_PAGE_SIZE));
+            break;
+        default:
+            if (obtained.commit == MemoryCommit::LAZY)
+            {
+                munmap(memory, size);
+            }
+            else
+            {
+                ::operator delete(memory, std::align_val_t(alignment));
+            }
+    }
+}
+
+MemoryCommit prefault_memory(void *memory, std::size_t size, bool lock)
+{
+    if (size == 0)
+    {
+        return lock ? MemoryCommit::LOCK : MemoryCommit::PREFAULT;
+    }
+    // madvise requires a page aligned address
+    std::uintptr_t start = reinterpret_cast<std::uintptr_t>(memory);
+    std::uintptr_t aligned_start = start - start % page_size();
+    std::size_t aligned_size = size + (start - aligned_start);
+    if (madvise(reinterpret_cast<void *>(aligned_start),
+                aligned_size,
+                MADV_POPULATE_WRITE) != 0)
+    {
+        // older kernels: write fault on each page, without modifying
+        // the content (the memory may be concurrently used by other
+        // processes)
+        char *bytes = static_cast<char *>(memory);
+        for (std::size_t offset = 0; offset < size; offset += page_size())
+        {
+            __atomic_fetch_add(bytes + offset, 0, __ATOMIC_RELAXED);
+        }
+        __atomic_fetch_add(bytes + size - 1, 0, __ATOMIC_RELAXED);
+    }
+    if (lock)
+    {
+        if (mlock(memory, size) == 0)
+        {
+            return MemoryCommit::LOCK;
+        }
+    }
+    return MemoryCommit::PREFAULT;
+}
+
+std::size_t resident_memory(const void *memory, std::size_t size)
+{
+    if (size == 0)
+    {
+        return 0;
+    }
+    std::uintptr_t start = reinterpret_cast<std::uintptr_t>(memory);
+    std::uintptr_t aligned_start = start - start % page_size();
+    std::size_t nb_pages =
+        (size + (start - aligned_start) + page_size() - 1) / page_size();
+    std::vector<unsigned char> residency(nb_pages);
+    if (mincore(reinterpret_cast<void *>(aligned_start),
+                nb_pages * page_size(),
+                residency.data()) != 0)
+    {
+        return 0;
+    }
+    std::size_t nb_resident = 0;
+    for (unsigned char page : residency)
+    {
+        nb_resident += page & 1;
+    }
+    return nb_resident * page_size();
+}
+
+std::size_t shared_memory_footprint(const std::string &shm_id)
+{
+    struct stat info;
+    if (stat(("/dev/shm/" + shm_id).c_str(), &info) != 0)
+    {
+        return 0;
+    }
+    return static_cast<std::size_t>(info.st_blocks) * 512;
+}
+
+bool is_hugetlbfs(const std::string &path)
+{
+    struct statfs info;
+    if (statfs(path.c_str(), &info) != 0)
+    {
+        return false;
+    }
+    return static_cast<unsigned long>(info.f_type) == HUGETLBFS_MAGIC;
+}
+
+}  // namespace internal
+}  // namespace time_series
@@ -4,12 +4,18 @@ namespace time_series
 {
 void clear_memory(std::string segment_id)
 {
-    shared_memory::clear_array(segment_id + internal::shm_indexes);
+    internal::SharedMemoryRegion::clear(segment_id + internal::shm_indexes);
+    internal::SharedMemoryRegion::clear(segment_id + internal::shm_period);
     shared_memory::clear_array(segment_id + internal::shm_elements);
     shared_memory::clear_array(segment_id + internal::shm_timestamps);
+    shared_memory::clear_array(segment_id +
+                               internal::shm_condition_variable +
+                               internal::shm_waiters);
     // shared memory wiped on destruction
     shared_memory::Mutex(segment_id + internal::shm_mutex, true);
     shared_memory::ConditionVariable(
         segment_id + internal::shm_condition_variable, true);
+    // single segment layout
+    internal::Segment::clear(segment_id);
 }
 }  // namespace time_series
@@ -0,0 +1,117 @@
+#include "time_series/reactor.hpp"
+
+#include <chrono>
+#include <stdexcept>
+#include <utility>
+
+namespace time_series
+{
+Reactor::Reactor(double period_s) : period_s_(period_s), stop_(false)
+{
+    if (!(period_s > 0))
+    {
+        throw std::invalid_argument("Reactor: period should be positive");
+    }
+    thread_ = std::thread(&Reactor::run, this);
+}
+
+Reactor::~Reactor()
+{
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        stop_ = true;
+    }
+    condition_.notify_all();
+    thread_.join();
+}
+
+std::size_t Reactor::pending() const
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    return waiters_.size();
+}
+
+void Reactor::add(std::function<bool()> ready, std::function<void()> callback)
+{
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        waiters_.push_back(Waiter{std::move(ready), std::move(callback)});
+    }
+    condition_.notify_all();
+}
+
+int Reactor::add_event_fd(std::function<Index()> newest)
+{
+    Watcher watcher{newest, newest(), std::make_unique<internal::EventFd>()};
+    int fd = watcher.event_fd->get();
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        watchers_.push_back(std::move(watcher));
+    }
+    condition_.notify_all();
+    return fd;
+}
+
+void Reactor::remove_event_fd(int fd)
+{
+    std::lock_guard<std::mutex> guard(mutex_);
+    for (std::size_t i = 0; i < watchers_.size(); i++)
+    {
+        if (watchers_[i].event_fd->get() == fd)
+        {
+            watchers_.erase(watchers_.begin() + i);
+            return;
+        }
+    }
+}
+
+void Reactor::run()
+{
+    std::chrono::duration<double> period(period_s_);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_)
+    {
+        if (waiters_.empty() && watchers_.empty())
+        {
+            condition_.wait(lock);
+            continue;
+        }
+        for (Watcher &watcher : watchers_)
+        {
+            Index newest = watcher.newest();
+            if (newest != watcher.last)
+            {
+                watcher.last = newest;
+                watcher.event_fd->notify();
+            }
+        }
+        std::vector<std::function<void()>> ready;
+        for (std::size_t i = 0; i < waiters_.size();)
+        {
+            if (waiters_[i].ready())
+            {
+                ready.push_back(std::move(waiters_[i].callback));
+                waiters_[i] = std::move(waiters_.back());
+                waiters_.pop_back();
+            }
+            else
+            {
+                i++;
+            }
+        }
+        if (!ready.empty())
+        {
+            // (callbacks may register again)
+            lock.unlock();
+            for (std::function<void()> &callback : ready)
+            {
+                callback();
+            }
+            lock.lock();
+            continue;
+        }
+        condition_.wait_for(lock, period);
+    }
+}
+
+}  // namespace time_series
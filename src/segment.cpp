@@ -0,0 +1,245 @@
+#include "time_series/internal/segment.hpp"
+
+#include <signal.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+namespace time_series
+{
+namespace internal
+{
+static std::size_t cache_line_ceil(std::size_t size)
+{
+    return ((size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE) * CACHE_LINE_SIZE;
+}
+
+Segment::Segment(std::unique_ptr<SharedMemoryRegion> region)
+    : region_(std::move(region))
+{
+}
+
+std::shared_ptr<Segment> Segment::create(const std::string &segment_id,
+                                         std::size_t max_length,
+                                         std::size_t slot_size,
+                                         bool timestamps,
+                                         std::uint64_t type_hash,
+                                         Index start_timeindex,
+                                         bool clear_on_destruction,
+                                         PageBacking page_backing,
+                                         MemoryCommit commit,
+                                         std::size_t arena_size,
+                                         LockProtocol lock_protocol)
+{
+    std::size_t timestamps_offset = cache_line_ceil(sizeof(SegmentHeader));
+    std::size_t slots_offset =
+        timestamps_offset +
+        (timestamps ? cache_line_ceil(max_length * sizeof(Timestamp)) : 0);
+    std::size_t arena_offset =
+        slots_offset + cache_line_ceil(max_length * slot_size);
+    std::size_t segment_size = arena_offset + arena_size;
+
+    // not reusing a segment left over by a previous leader:
+    // its synchronization primitives may be in any state
+    clear(segment_id);
+    std::unique_ptr<SharedMemoryRegion> region(
+        new SharedMemoryRegion(segment_id + shm_segment,
+                               segment_size,
+                               true,
+                               clear_on_destruction,
+                               page_backing));
+
+    SegmentHeader *header = new (region->data()) SegmentHeader;
+    header->version = SEGMENT_VERSION;
+    header->type_hash = type_hash;
+    header->max_length = max_length;
+    header->slot_size = slot_size;
+    header->timestamps = timestamps;
+    header->timestamps_offset = timestamps_offset;
+    header->slots_offset = slots_offset;
+    header->arena_offset = arena_offset;
+    header->arena_size = arena_size;
+    header->segment_size = segment_size;
+    header->page_backing = region->page_backing();
+    header->leader_pid = getpid();
+    new (&header->indexes) Indexes(start_timeindex);
+    header->waiters = 0;
+    header->arena_head = 0;
+    new (&header->period_tracker) PeriodTracker();
+
+    pthread_mutexattr_t mutex_attributes;
+    pthread_mutexattr_init(&mutex_attributes);
+    pthread_mutexattr_setpshared(&mutex_attributes, PTHREAD_PROCESS_SHARED);
+    // a process dying while holding the mutex does not hang the others
+    // (see recover)
+    pthread_mutexattr_setrobust(&mutex_attributes, PTHREAD_MUTEX_ROBUST);
+    if (lock_protocol == LockProtocol::PRIORITY_INHERITANCE)
+    {
+        int r = pthread_mutexattr_setprotocol(&mutex_attributes,
+                                              PTHREAD_PRIO_INHERIT);
+        if (r != 0)
+        {
+            pthread_mutexattr_destroy(&mutex_attributes);
+            throw std::runtime_error(
+                "failing to create the segment " + segment_id +
+                ": priority inheritance not supported (" +
+                std::string(std::strerror(r)) + ")");
+        }
+    }
+    pthread_mutex_init(&header->mutex, &mutex_attributes);
+    pthread_mutexattr_destroy(&mutex_attributes);
+
+    pthread_condattr_t condition_attributes;
+    pthread_condattr_init(&condition_attributes);
+    pthread_condattr_setpshared(&condition_attributes, PTHREAD_PROCESS_SHARED);
+    // timed waits are based on the monotonic clock
+    pthread_condattr_setclock(&condition_attributes, CLOCK_MONOTONIC);
+    pthread_cond_init(&header->condition, &condition_attributes);
+    pthread_condattr_destroy(&condition_attributes);
+
+    region->commit(commit);
+
+    header->magic.store(SEGMENT_MAGIC, std::memory_order_release);
+
+    return std::shared_ptr<Segment>(new Segment(std::move(region)));
+}
+
+// maps the segment created by a leader, checking its header
+// (and the type of the elements, if check_type)
+static std::unique_ptr<SharedMemoryRegion> open_segment(
+    const std::string &segment_id, std::uint64_t type_hash, bool check_type)
+{
+    std::unique_ptr<SharedMemoryRegion> region;
+    try
+    {
+        // size 0: mapping the full segment, as created by the leader
+        region.reset(
+            new SharedMemoryRegion(segment_id + shm_segment, 0, false, false));
+    }
+    catch (const std::runtime_error &)
+    {
+        throw std::runtime_error(
+            "failing to attach to the segment " + segment_id +
+            ": a corresponding leader should be started first");
+    }
+    if (region->size() < sizeof(SegmentHeader))
+    {
+        throw std::runtime_error("failing to attach to the segment " +
+                                 segment_id + ": unexpected size");
+    }
+    const SegmentHeader *header =
+        static_cast<const SegmentHeader *>(region->data());
+    if (header->magic.load(std::memory_order_acquire) != SEGMENT_MAGIC)
+    {
+        throw std::runtime_error(
+            "failing to attach to the segment " + segment_id +
+            ": the segment is not initialized (leader starting ?)");
+    }
+    if (header->version != SEGMENT_VERSION)
+    {
+        throw std::runtime_error("failing to attach to the segment " +
+                                 segment_id + ": unsupported version " +
+                                 std::to_string(header->version));
+    }
+    if (check_type && header->type_hash != type_hash)
+    {
+        throw std::runtime_error(
+            "failing to attach to the segment " + segment_id +
+            ": the leader uses a different type of elements");
+    }
+    if (region->size() < header->segment_size)
+    {
+        throw std::runtime_error("failing to attach to the segment " +
+                                 segment_id + ": unexpected size");
+    }
+    if (header->page_backing == PageBacking::TRANSPARENT_HUGE_PAGES)
+    {
+        region->advise_huge_pages();
+    }
+    return region;
+}
+
+std::shared_ptr<Segment> Segment::attach(const std::string &segment_id,
+                                         std::uint64_t type_hash,
+                                         MemoryCommit commit)
+{
+    std::unique_ptr<SharedMemoryRegion> region =
+        open_segment(segment_id, type_hash, true);
+    region->commit(commit);
+    return std::shared_ptr<Segment>(new Segment(std::move(region)));
+}
+
+std::shared_ptr<Segment> Segment::reattach(const std::string &segment_id,
+                                           std::uint64_t type_hash,
+                                           MemoryCommit commit)
+{
+    std::unique_ptr<SharedMemoryRegion> region =
+        open_segment(segment_id, type_hash, true);
+    SegmentHeader *header = static_cast<SegmentHeader *>(region->data());
+    pid_t previous = header->leader_pid.load();
+    // (compare and exchange: of several processes reattaching
+    // concurrently, only one becomes the leader)
+    if ((previous != getpid() &&
+         (kill(previous, 0) == 0 || errno == EPERM)) ||
+        !header->leader_pid.compare_exchange_strong(previous, getpid()))
+    {
+        throw std::runtime_error(
+            "failing to reattach to the segment " + segment_id +
+            ": its leader (pid " + std::to_string(previous) +
+            ") is still running");
+    }
+    region->set_clear_on_destruction(true);
+    region->commit(commit);
+    return std::shared_ptr<Segment>(new Segment(std::move(region)));
+}
+
+std::shared_ptr<Segment> Segment::inspect(const std::string &segment_id)
+{
+    // (no commit: only the pages of the header get faulted in, when read)
+    return std::shared_ptr<Segment>(
+        new Segment(open_segment(segment_id, 0, false)));
+}
+
+void Segment::clear(const std::string &segment_id)
+{
+    SharedMemoryRegion::clear(segment_id + shm_segment);
+}
+
+void Segment::recover() const
+{
+    // the dead process may have been in the middle of write_indexes
+    // (which writes newest last): the element of index newest is complete,
+    // oldest is brought back in the range it may take given newest.
+    // If it was appending (writing set), it may also have been writing the
+    // element newest + 1: once the ring is full, its slot is the slot of
+    // the oldest element, which is then dropped (for a max length of 1,
+    // this is the newest element: the time series is then left empty,
+    // oldest being newest + 1). A dead reader does not drop any element.
+    SegmentHeader *h = header();
+    h->period_tracker.recover();
+    Indexes &indexes = h->indexes;
+    bool writing = indexes.writing.load();
+    indexes.writing = false;
+    Index start = indexes.start.load();
+    Index newest = indexes.newest.load();
+    if (newest < start)
+    {
+        indexes.oldest = start;
+        return;
+    }
+    Index oldest = indexes.oldest.load();
+    oldest = std::max(oldest, start);
+    oldest = std::max(oldest, newest - static_cast<Index>(h->max_length) + 1);
+    if (writing && newest - oldest + 1 == static_cast<Index>(h->max_length))
+    {
+        oldest++;
+    }
+    indexes.oldest = std::min(oldest, newest + 1);
+}
+
+}  // namespace internal
+}  // namespace time_series
@@ -0,0 +1,137 @@
+#include "time_series/segment_monitor.hpp"
+
+#include <dirent.h>
+#include <signal.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <set>
+#include <stdexcept>
+
+#include "time_series/internal/memory.hpp"
+#include "time_series/multiprocess_time_series.hpp"
+
+namespace time_series
+{
+// directory of the POSIX shared memory objects
+static const std::string shm_directory("/dev/shm");
+
+static bool ends_with(const std::string &name, const std::string &suffix)
+{
+    return name.size() > suffix.size() &&
+           name.compare(name.size() - suffix.size(), suffix.size(), suffix) ==
+               0;
+}
+
+// adds to ids the names of the files of directory ending with suffix
+// (without the suffix)
+static void list_ids(const std::string &directory,
+                     const std::string &suffix,
+                     std::set<std::string> &ids)
+{
+    DIR *dir = opendir(directory.c_str());
+    if (dir == nullptr)
+    {
+        return;
+    }
+    while (struct dirent *entry = readdir(dir))
+    {
+        std::string name(entry->d_name);
+        if (ends_with(name, suffix))
+        {
+            ids.insert(name.substr(0, name.size() - suffix.size()));
+        }
+    }
+    closedir(dir);
+}
+
+SegmentMonitor::SegmentMonitor(const std::string &segment_id)
+    : segment_id_(segment_id), max_length_(0)
+{
+    try
+    {
+        segment_ = internal::Segment::inspect(segment_id);
+        return;
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+    try
+    {
+        indexes_region_ = std::make_shared<internal::SharedMemoryRegion>(
+            segment_id + internal::shm_indexes,
+            sizeof(internal::Indexes),
+            false,
+            false);
+        shared_memory::get<size_t>(segment_id, "max_length", max_length_);
+    }
+    catch (const std::exception &)
+    {
+        throw std::runtime_error("SegmentMonitor: no time series " +
+                                 segment_id + " in shared memory");
+    }
+    try
+    {
+        period_region_ = std::make_shared<internal::SharedMemoryRegion>(
+            segment_id + internal::shm_period,
+            sizeof(internal::PeriodTracker),
+            false,
+            false);
+    }
+    catch (const std::runtime_error &)
+    {
+        // time series without the TrackPeriod policy
+    }
+}
+
+SegmentStatus SegmentMonitor::status() const
+{
+    SegmentStatus status;
+    status.segment_id = segment_id_;
+    status.single_segment = static_cast<bool>(segment_);
+    const internal::Indexes *indexes;
+    if (segment_)
+    {
+        const internal::SegmentHeader *header = segment_->header();
+        indexes = &header->indexes;
+        status.max_length = header->max_length;
+        status.waiters = __atomic_load_n(&header->waiters, __ATOMIC_RELAXED);
+        status.leader_pid = header->leader_pid.load(std::memory_order_relaxed);
+        status.leader_alive =
+            kill(status.leader_pid, 0) == 0 || errno == EPERM;
+        status.period = header->period_tracker.read();
+    }
+    else
+    {
+        indexes =
+            static_cast<const internal::Indexes *>(indexes_region_->data());
+        status.max_length = max_length_;
+        status.waiters = -1;
+        status.leader_pid = 0;
+        status.leader_alive = true;
+        if (period_region_)
+        {
+            status.period = static_cast<const internal::PeriodTracker *>(
+                                period_region_->data())
+                                ->read();
+        }
+    }
+    // (not locking: oldest may be outdated by the time newest is read,
+    // see SegmentStatus::length)
+    status.start = indexes->start.load(std::memory_order_relaxed);
+    status.oldest = indexes->oldest.load(std::memory_order_acquire);
+    status.newest = indexes->newest.load(std::memory_order_acquire);
+    status.tagged = indexes->tagged.load(std::memory_order_relaxed);
+    return status;
+}
+
+std::vector<std::string> SegmentMonitor::discover()
+{
+    std::set<std::string> ids;
+    list_ids(shm_directory, internal::shm_segment, ids);
+    list_ids(internal::hugetlbfs_mount, internal::shm_segment, ids);
+    list_ids(shm_directory, internal::shm_indexes, ids);
+    return std::vector<std::string>(ids.begin(), ids.end());
+}
+
+}  // namespace time_series
@@ -0,0 +1,193 @@
+#include "time_series/internal/shared_memory_region.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include "time_series/internal/memory.hpp"
+
+namespace time_series
+{
+namespace internal
+{
+static std::string shm_name(const std::string& region_id)
+{
+    return "/" + region_id;
+}
+
+static std::string hugetlbfs_path(const std::string& region_id)
+{
+    return hugetlbfs_mount + "/" + region_id;
+}
+
+static std::runtime_error region_error(const std::string& region_id,
+                                       const std::string& what)
+{
+    return std::runtime_error("time_series: shared memory region " +
+                              region_id + ": " + what + " (" +
+                              std::strerror(errno) + ")");
+}
+
+// resize (if size is not 0) and map the file, returns nullptr on failure.
+// The file descriptor is closed (the mapping remains valid).
+static void* map(int fd, std::size_t size, bool resize)
+{
+    if (resize && ftruncate(fd, size) != 0)
+    {
+        close(fd);
+        return nullptr;
+    }
+    void* data =
+        mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        return nullptr;
+    }
+    return data;
+}
+
+SharedMemoryRegion::SharedMemoryRegion(const std::string& region_id,
+                                       std::size_t size,
+                                       bool create,
+                                       bool clear_on_destruction,
+                                       PageBacking page_backing)
+    : region_id_(region_id),
+      size_(size),
+      clear_on_destruction_(clear_on_destruction),
+      data_(nullptr),
+      page_backing_(PageBacking::DEFAULT_PAGES),
+      memory_commit_(MemoryCommit::DEFAULT)
+{
+    if (create)
+    {
+        this->create(page_backing);
+    }
+    else
+    {
+        open();
+    }
+}
+
+void SharedMemoryRegion::create(PageBacking page_backing)
+{
+    if (page_backing == PageBacking::HUGE_PAGES &&
+        is_hugetlbfs(hugetlbfs_mount))
+    {
+        std::string path = hugetlbfs_path(region_id_);
+        int fd = ::open(path.c_str(), O_CREAT | O_RDWR, 0666);
+        if (fd >= 0)
+        {
+            // (fails if not enough huge pages are available)
+            data_ = map(fd, huge_page_ceil(size_), true);
+            if (data_ != nullptr)
+            {
+                size_ = huge_page_ceil(size_);
+                page_backing_ = PageBacking::HUGE_PAGES;
+                return;
+            }
+            unlink(path.c_str());
+        }
+    }
+    if (page_backing != PageBacking::DEFAULT_PAGES)
+    {
+        size_ = huge_page_ceil(size_);
+    }
+    int fd = shm_open(shm_name(region_id_).c_str(), O_CREAT | O_RDWR, 0666);
+    if (fd < 0)
+    {
+        throw region_error(region_id_, "failed to open");
+    }
+    data_ = map(fd, size_, true);
+    if (data_ == nullptr)
+    {
+        throw region_error(region_id_, "failed to map");
+    }
+    if (page_backing != PageBacking::DEFAULT_PAGES && advise_huge_pages())
+    {
+        page_backing_ = PageBacking::TRANSPARENT_HUGE_PAGES;
+    }
+}
+
+void SharedMemoryRegion::open()
+{
+    int fd = shm_open(shm_name(region_id_).c_str(), O_RDWR, 0666);
+    if (fd < 0 && errno == ENOENT)
+    {
+        // the leader may have created the region on hugetlbfs
+        fd = ::open(hugetlbfs_path(region_id_).c_str(), O_RDWR);
+        if (fd >= 0)
+        {
+            page_backing_ = PageBacking::HUGE_PAGES;
+        }
+    }
+    if (fd < 0)
+    {
+        throw region_error(region_id_, "failed to open");
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0 ||
+        static_cast<std::size_t>(info.st_size) < size_)
+    {
+        close(fd);
+        errno = EINVAL;
+        throw region_error(region_id_, "unexpected size");
+    }
+    if (size_ == 0)
+    {
+        size_ = info.st_size;
+    }
+    data_ = map(fd, size_, false);
+    if (data_ == nullptr)
+    {
+        throw region_error(region_id_, "failed to map");
+    }
+}
+
+bool SharedMemoryRegion::advise_huge_pages()
+{
+    if (page_backing_ == PageBacking::HUGE_PAGES)
+    {
+        return true;
+    }
+    if (madvise(data_, size_, MADV_HUGEPAGE) == 0)
+    {
+        page_backing_ = PageBacking::TRANSPARENT_HUGE_PAGES;
+        return true;
+    }
+    return false;
+}
+
+MemoryCommit SharedMemoryRegion::commit(MemoryCommit commit)
+{
+    memory_commit_ = commit;
+    if (commit == MemoryCommit::PREFAULT || commit == MemoryCommit::LOCK)
+    {
+        memory_commit_ =
+            prefault_memory(data_, size_, commit == MemoryCommit::LOCK);
+    }
+    return memory_commit_;
+}
+
+SharedMemoryRegion::~SharedMemoryRegion()
+{
+    munmap(data_, size_);
+    if (clear_on_destruction_)
+    {
+        clear(region_id_);
+    }
+}
+
+void SharedMemoryRegion::clear(const std::string& region_id)
+{
+    shm_unlink(shm_name(region_id).c_str());
+    unlink(hugetlbfs_path(region_id).c_str());
+}
+
+}  // namespace internal
+}  // namespace time_series
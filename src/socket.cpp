@@ -0,0 +1,252 @@
+#include "time_series/internal/socket.hpp"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace time_series
+{
+namespace internal
+{
+static std::runtime_error socket_error(const std::string& what)
+{
+    return std::runtime_error("stream bridge: " + what + ": " +
+                              std::strerror(errno));
+}
+
+static sockaddr_un unix_address(const std::string& path)
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path))
+    {
+        throw std::runtime_error("stream bridge: socket path too long: " +
+                                 path);
+    }
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    return address;
+}
+
+int listen_tcp(const std::string& host, int port)
+{
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    int error = getaddrinfo(host.c_str(), nullptr, &hints, &addresses);
+    if (error != 0)
+    {
+        throw std::runtime_error("stream bridge: failed to resolve " + host +
+                                 ": " + gai_strerror(error));
+    }
+    sockaddr_in address;
+    std::memcpy(&address, addresses->ai_addr, sizeof(address));
+    freeaddrinfo(addresses);
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        throw socket_error("failed to create socket");
+    }
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+        listen(fd, 16) < 0)
+    {
+        std::runtime_error error = socket_error(
+            "failed to listen on " + host + ":" + std::to_string(port));
+        close(fd);
+        throw error;
+    }
+    return fd;
+}
+
+int listen_unix(const std::string& path)
+{
+    sockaddr_un address = unix_address(path);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        throw socket_error("failed to create socket");
+    }
+    unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+        listen(fd, 16) < 0)
+    {
+        std::runtime_error error = socket_error("failed to listen on " + path);
+        close(fd);
+        throw error;
+    }
+    return fd;
+}
+
+int bound_port(int fd)
+{
+    sockaddr_in address;
+    socklen_t size = sizeof(address);
+    if (getsockname(fd, reinterpret_cast<sockaddr*>(&address), &size) < 0)
+    {
+        throw socket_error("failed to get the bound port");
+    }
+    return ntohs(address.sin_port);
+}
+
+int accept_connection(int listen_fd)
+{
+    while (true)
+    {
+        int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd >= 0)
+        {
+            int one = 1;
+            // (fails, harmlessly, on UNIX domain sockets)
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            return fd;
+        }
+        if (errno == EINTR || errno == ECONNABORTED)
+        {
+            continue;
+        }
+        // shut down (EINVAL) or closed
+        return -1;
+    }
+}
+
+int connect_tcp(const std::string& host, int port)
+{
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    int error = getaddrinfo(
+        host.c_str(), std::to_string(port).c_str(), &hints, &addresses);
+    if (error != 0)
+    {
+        throw std::runtime_error("stream bridge: failed to resolve " + host +
+                                 ": " + gai_strerror(error));
+    }
+    int fd = -1;
+    for (addrinfo* a = addresses; a != nullptr && fd < 0; a = a->ai_next)
+    {
+        fd = socket(a->ai_family, a->ai_socktype | SOCK_CLOEXEC, a->ai_protocol);
+        if (fd >= 0 && connect(fd, a->ai_addr, a->ai_addrlen) < 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(addresses);
+    if (fd < 0)
+    {
+        throw socket_error("failed to connect to " + host + ":" +
+                           std::to_string(port));
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+int connect_unix(const std::string& path)
+{
+    sockaddr_un address = unix_address(path);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        throw socket_error("failed to create socket");
+    }
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) <
+        0)
+    {
+        std::runtime_error error = socket_error("failed to connect to " + path);
+        close(fd);
+        throw error;
+    }
+    return fd;
+}
+
+bool send_all(int fd, const void* data, std::size_t size)
+{
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0)
+    {
+        ssize_t sent = send(fd, bytes, size, MSG_NOSIGNAL);
+        if (sent < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        bytes += sent;
+        size -= static_cast<std::size_t>(sent);
+    }
+    return true;
+}
+
+bool receive_all(int fd, void* data, std::size_t size)
+{
+    char* bytes = static_cast<char*>(data);
+    while (size > 0)
+    {
+        ssize_t received = recv(fd, bytes, size, 0);
+        if (received < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (received <= 0)
+        {
+            return false;
+        }
+        bytes += received;
+        size -= static_cast<std::size_t>(received);
+    }
+    return true;
+}
+
+bool peer_closed(int fd)
+{
+    pollfd request;
+    request.fd = fd;
+    request.events = POLLIN;
+    request.revents = 0;
+    if (poll(&request, 1, 0) <= 0)
+    {
+        return false;
+    }
+    if (request.revents & (POLLHUP | POLLERR | POLLNVAL))
+    {
+        return true;
+    }
+    // readable: end of stream (or unexpected data, ignored)
+    char byte;
+    ssize_t received = recv(fd, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+    return received == 0 ||
+           (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK &&
+            errno != EINTR);
+}
+
+void shutdown_socket(int fd)
+{
+    shutdown(fd, SHUT_RDWR);
+}
+
+void close_socket(int fd)
+{
+    close(fd);
+}
+
+}  // namespace internal
+}  // namespace time_series
@@ -0,0 +1,78 @@
+#include "time_series/worker_pool.hpp"
+
+#include <utility>
+
+namespace time_series
+{
+WorkerPool::WorkerPool(std::size_t nb_threads) : stop_(false)
+{
+    if (nb_threads == 0)
+    {
+        nb_threads = std::thread::hardware_concurrency();
+        if (nb_threads == 0)
+        {
+            nb_threads = 1;
+        }
+    }
+    for (std::size_t i = 0; i < nb_threads; i++)
+    {
+        threads_.emplace_back(&WorkerPool::run, this);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        stop_ = true;
+        tasks_.clear();
+    }
+    condition_.notify_all();
+    for (std::thread& thread : threads_)
+    {
+        thread.join();
+    }
+}
+
+void WorkerPool::post(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        if (stop_)
+        {
+            return;
+        }
+        tasks_.push_back(std::move(task));
+    }
+    condition_.notify_one();
+}
+
+WorkerPool::Executor WorkerPool::executor()
+{
+    return [this](std::function<void()> task) { post(std::move(task)); };
+}
+
+std::size_t WorkerPool::size() const
+{
+    return threads_.size();
+}
+
+void WorkerPool::run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        condition_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+        if (stop_)
+        {
+            return;
+        }
+        std::function<void()> task = std::move(tasks_.front());
+        tasks_.pop_front();
+        lock.unlock();
+        task();
+        lock.lock();
+    }
+}
+
+}  // namespace time_series
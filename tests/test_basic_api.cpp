@@ -1,9 +1,31 @@
 
 #include <gtest/gtest.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
 #include <eigen3/Eigen/Core>
+#include <eigen3/Eigen/Geometry>
+#include <thread>
+#include <vector>
 
+#include "time_series/compressed_time_series.hpp"
+#include "time_series/element_storage.hpp"
+#include "time_series/mapped_time_series.hpp"
+#include "time_series/multi_producer_time_series.hpp"
+#include "time_series/multiprocess_payload_time_series.hpp"
 #include "time_series/multiprocess_time_series.hpp"
+#include "time_series/reactor.hpp"
+#include "time_series/segment_monitor.hpp"
+#include "time_series/stream_bridge.hpp"
 #include "time_series/time_series.hpp"
+#include "time_series/timestamp_join.hpp"
+#include "time_series/worker_pool.hpp"
 
 #include "real_time_tools/mutex.hpp"
 #include "real_time_tools/thread.hpp"
@@ -300,3 +322,1732 @@ TEST(time_series_ut, multi_processes_empty)
     ASSERT_FALSE(ts1.is_empty());
     ASSERT_FALSE(ts2.is_empty());
 }
+
+void *wait_for_element(void *args)
+{
+    TimeSeries<int> &ts = *static_cast<TimeSeries<int> *>(args);
+    int value = ts[1];
+    ts.append(value + 1);
+    return nullptr;
+}
+
+TEST(time_series_ut, waiters_notified)
+{
+    TimeSeries<int> ts(100);
+    // no waiter: append does not notify
+    ts.append(10);
+    // waiter timing out: the waiter count must be decremented
+    ASSERT_FALSE(ts.wait_for_timeindex(1, 0.001));
+    RealTimeThread thread;
+    thread.create_realtime_thread(&wait_for_element, &ts);
+    usleep(2000);
+    ts.append(20);
+    ASSERT_TRUE(ts.wait_for_timeindex(2, 1.0));
+    ASSERT_EQ(ts[2], 21);
+    thread.join();
+}
+
+void *wait_for_element_mp(void *)
+{
+    typedef MultiprocessTimeSeries<int> Mpt;
+    Mpt ts = Mpt::create_follower(SEGMENT_ID);
+    int value = ts[1];
+    ts.append(value + 1);
+    return nullptr;
+}
+
+TEST(time_series_ut, multi_processes_waiters_notified)
+{
+    clear_memory(SEGMENT_ID);
+    typedef MultiprocessTimeSeries<int> Mpt;
+    Mpt ts = Mpt::create_leader(SEGMENT_ID, 100);
+    ts.append(10);
+    ASSERT_FALSE(ts.wait_for_timeindex(1, 0.001));
+    RealTimeThread thread;
+    thread.create_realtime_thread(&wait_for_element_mp);
+    usleep(2000);
+    ts.append(20);
+    ASSERT_TRUE(ts.wait_for_timeindex(2, 1.0));
+    ASSERT_EQ(ts[2], 21);
+    thread.join();
+}
+
+TEST(time_series_ut, eigen_aligned_range)
+{
+    typedef Eigen::Matrix4d M;
+    TimeSeries<M> ts(10);
+    for (int i = 0; i < 15; i++)
+    {
+        ts.append(M::Constant(i));
+    }
+    std::vector<double> sums;
+    std::size_t nb_chunks = 0;
+    ts.visit_range(7, 14, [&](const M *elements, std::size_t nb_elements) {
+        nb_chunks++;
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(elements) % alignof(M),
+                  (std::uintptr_t)0);
+        for (std::size_t i = 0; i < nb_elements; i++)
+        {
+            sums.push_back(elements[i].sum());
+        }
+    });
+    // 7, 8, 9 at the end of the ring, 10 to 14 at its start
+    ASSERT_EQ(nb_chunks, (std::size_t)2);
+    ASSERT_EQ(sums.size(), (std::size_t)8);
+    for (std::size_t i = 0; i < sums.size(); i++)
+    {
+        ASSERT_EQ(sums[i], 16. * (7 + i));
+    }
+    ASSERT_THROW(ts.visit_range(2, 5, [](const M *, std::size_t) {}),
+                 std::invalid_argument);
+}
+
+TEST(time_series_ut, multi_processes_read_only_queries)
+{
+    clear_memory(SEGMENT_ID);
+    typedef MultiprocessTimeSeries<int> Mpt;
+    Mpt leader = Mpt::create_leader(SEGMENT_ID, 10, 3);
+    Mpt follower = Mpt::create_follower(SEGMENT_ID);
+    ASSERT_EQ(follower.newest_timeindex(false), EMPTY);
+    ASSERT_EQ(follower.oldest_timeindex(false), EMPTY);
+    ASSERT_EQ(follower.length(), (size_t)0);
+    ASSERT_EQ(follower.count_appended_elements(), 0);
+    for (int i = 0; i < 15; i++)
+    {
+        leader.append(i);
+    }
+    ASSERT_EQ(follower.newest_timeindex(false), 17);
+    ASSERT_EQ(follower.oldest_timeindex(false), 8);
+    ASSERT_EQ(follower.length(), (size_t)10);
+    ASSERT_EQ(follower.max_length(), (size_t)10);
+    ASSERT_EQ(follower.count_appended_elements(), 15);
+    ASSERT_FALSE(follower.is_empty());
+    ASSERT_EQ(follower[8], 5);
+}
+
+TEST(time_series_ut, single_segment)
+{
+    clear_memory(SEGMENT_ID);
+    typedef MultiprocessTimeSeries<int, SingleSegment> Mpt;
+    ASSERT_THROW(Mpt::create_follower(SEGMENT_ID), std::runtime_error);
+    Mpt leader = Mpt::create_leader(SEGMENT_ID, 10, 4);
+    Mpt follower = Mpt::create_follower(SEGMENT_ID);
+    ASSERT_EQ(Mpt::get_max_length(SEGMENT_ID), (size_t)10);
+    ASSERT_EQ(Mpt::get_start_timeindex(SEGMENT_ID), 4);
+    ASSERT_EQ(follower.max_length(), (size_t)10);
+    ASSERT_TRUE(follower.is_empty());
+    for (int i = 0; i < 15; i++)
+    {
+        leader.append(i);
+    }
+    ASSERT_EQ(follower.newest_timeindex(), 18);
+    ASSERT_EQ(follower.oldest_timeindex(), 9);
+    ASSERT_EQ(follower[18], 14);
+    ASSERT_EQ(follower.timestamp_ms(18), leader.timestamp_ms(18));
+    follower.append(100);
+    ASSERT_EQ(leader.newest_element(), 100);
+    ASSERT_FALSE(follower.wait_for_timeindex(20, 0.001));
+    // followers of another element type are rejected
+    typedef MultiprocessTimeSeries<double, SingleSegment> Mptd;
+    ASSERT_THROW(Mptd::create_follower(SEGMENT_ID), std::runtime_error);
+}
+
+// Type is trivially copyable, hence stored raw by default:
+// forcing its serialization (see StorageMethodOf)
+struct SerializedType : Type
+{
+};
+
+namespace time_series
+{
+template <>
+struct StorageMethodOf<SerializedType>
+{
+    static constexpr StorageMethod value = StorageMethod::SERIALIZED;
+};
+}  // namespace time_series
+
+void *add_element_single_segment(void *)
+{
+    typedef MultiprocessTimeSeries<SerializedType, SingleSegment> Mpt;
+    Mpt ts = Mpt::create_follower(SEGMENT_ID);
+    usleep(2000);
+    SerializedType t;
+    t.set(5, 10, 20.0);
+    ts.append(t);
+    return nullptr;
+}
+
+TEST(time_series_ut, single_segment_serialized)
+{
+    clear_memory(SEGMENT_ID);
+    typedef MultiprocessTimeSeries<SerializedType, SingleSegment> Mpt;
+    Mpt ts = Mpt::create_leader(SEGMENT_ID, 100);
+    RealTimeThread thread;
+    thread.create_realtime_thread(&add_element_single_segment);
+    SerializedType t = ts.newest_element();
+    ASSERT_EQ(t.get(5, 10), 20.0);
+    thread.join();
+    shared_memory::Serializer<SerializedType> serializer;
+    SerializedType t2;
+    serializer.deserialize(ts.get_raw(0), t2);
+    ASSERT_TRUE(t == t2);
+}
+
+TEST(time_series_ut, page_backing)
+{
+    // huge pages may not be available: checking only that
+    // the time series is functional whatever the backing obtained
+    TimeSeries<int> ts1(100);
+    ASSERT_EQ(ts1.page_backing(), PageBacking::DEFAULT_PAGES);
+    TimeSeries<int> ts2(100, 0, true, PageBacking::HUGE_PAGES);
+    ts2.append(10);
+    ASSERT_EQ(ts2[0], 10);
+
+    clear_memory(SEGMENT_ID);
+    typedef MultiprocessTimeSeries<int, SingleSegment> Mpt;
+    Mpt leader =
+        Mpt::create_leader(SEGMENT_ID, 100, 0, PageBacking::HUGE_PAGES);
+    Mpt follower = Mpt::create_follower(SEGMENT_ID);
+    ASSERT_EQ(leader.page_backing(), follower.page_backing());
+    leader.append(10);
+    ASSERT_EQ(follower[0], 10);
+}
+
+TEST(time_series_ut, memory_commit)
+{
+    size_t max_length = 1000000;
+    size_t storage = max_length * (sizeof(double) + sizeof(Timestamp));
+    TimeSeries<double> lazy(
+        max_length, 0, true, PageBacking::DEFAULT_PAGES, MemoryCommit::LAZY);
+    ASSERT_EQ(lazy.memory_commit(), MemoryCommit::LAZY);
+    ASSERT_LT(lazy.resident_memory(), storage / 10);
+    lazy.append(1.0);
+    ASSERT_EQ(lazy[0], 1.0);
+    TimeSeries<double> prefaulted(max_length,
+                                  0,
+                                  true,
+                                  PageBacking::DEFAULT_PAGES,
+                                  MemoryCommit::PREFAULT);
+    ASSERT_EQ(prefaulted.memory_commit(), MemoryCommit::PREFAULT);
+    ASSERT_GE(prefaulted.resident_memory(), storage);
+    // falls back on PREFAULT if not allowed to lock
+    TimeSeries<double> locked(
+        1000, 0, true, PageBacking::DEFAULT_PAGES, MemoryCommit::LOCK);
+    ASSERT_NE(locked.memory_commit(), MemoryCommit::DEFAULT);
+
+    clear_memory(SEGMENT_ID);
+    typedef MultiprocessTimeSeries<double, SingleSegment> Mpt;
+    Mpt leader = Mpt::create_leader(SEGMENT_ID, max_length);
+    ASSERT_LT(leader.resident_memory(), storage / 10);
+    Mpt follower = Mpt::create_follower(SEGMENT_ID, MemoryCommit::PREFAULT);
+    ASSERT_EQ(follower.memory_commit(), MemoryCommit::PREFAULT);
+    ASSERT_GE(leader.resident_memory(), storage);
+}
+
+struct ProducerValue
+{
+    int producer;
+    int value;
+};
+
+TEST(time_series_ut, multi_producers)
+{
+    constexpr int nb_producers = 4;
+    constexpr int nb_elements = 20000;
+    constexpr Index total = nb_producers * nb_elements;
+    MultiProducerTimeSeries<ProducerValue> ts(total);
+    ASSERT_TRUE(ts.is_empty());
+    ASSERT_FALSE(ts.wait_for_timeindex(0, 0.001));
+
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < nb_producers; producer++)
+    {
+        producers.emplace_back([&ts, producer]() {
+            for (int value = 0; value < nb_elements; value++)
+            {
+                ts.append(ProducerValue{producer, value});
+            }
+        });
+    }
+    // reading while the producers append: only published elements
+    // are observed, in a contiguous prefix
+    std::vector<int> last(nb_producers, -1);
+    for (Index index = 0; index < total; index++)
+    {
+        ProducerValue element = ts[index];
+        ASSERT_LE(index, ts.newest_timeindex());
+        // elements of a same producer are in order
+        ASSERT_EQ(element.value, last[element.producer] + 1);
+        last[element.producer] = element.value;
+    }
+    for (std::thread& producer : producers)
+    {
+        producer.join();
+    }
+    ASSERT_EQ(ts.newest_timeindex(), total - 1);
+    ASSERT_EQ(ts.count_appended_elements(), total);
+    ASSERT_EQ(ts.length(), static_cast<size_t>(total));
+    for (int producer = 0; producer < nb_producers; producer++)
+    {
+        ASSERT_EQ(last[producer], nb_elements - 1);
+    }
+}
+
+TEST(time_series_ut, multi_producers_overwrite)
+{
+    constexpr int nb_producers = 4;
+    MultiProducerTimeSeries<ProducerValue> ts(100, 10);
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < nb_producers; producer++)
+    {
+        producers.emplace_back([&ts, producer]() {
+            for (int value = 0; value < 1000; value++)
+            {
+                ts.append(ProducerValue{producer, value});
+            }
+        });
+    }
+    for (std::thread& producer : producers)
+    {
+        producer.join();
+    }
+    ASSERT_EQ(ts.newest_timeindex(), 4009);
+    ASSERT_EQ(ts.oldest_timeindex(), 3910);
+    ASSERT_EQ(ts.length(), 100u);
+    ASSERT_THROW(ts[3909], std::invalid_argument);
+    // the elements (and timestamps) of concurrent producers interleave
+    // in any order, only those of a same producer are ordered
+    std::vector<int> last_value(nb_producers, -1);
+    std::vector<Timestamp> last_stamp(nb_producers, 0);
+    for (Index index = 3910; index <= 4009; index++)
+    {
+        ProducerValue element = ts[index];
+        ASSERT_GT(element.value, last_value[element.producer]);
+        ASSERT_GE(ts.timestamp_ms(index), last_stamp[element.producer]);
+        last_value[element.producer] = element.value;
+        last_stamp[element.producer] = ts.timestamp_ms(index);
+    }
+    ASSERT_EQ(ts.newest_element().producer, ts[4009].producer);
+    ASSERT_EQ(ts.newest_element().value, ts[4009].value);
+    ts.tag(4009);
+    ASSERT_FALSE(ts.has_changed_since_tag());
+}
+
+TEST(time_series_ut, payload_arena)
+{
+    clear_memory(SEGMENT_ID);
+    MultiprocessPayloadTimeSeries leader =
+        MultiprocessPayloadTimeSeries::create_leader(SEGMENT_ID, 100, 1000);
+    MultiprocessPayloadTimeSeries follower =
+        MultiprocessPayloadTimeSeries::create_follower(SEGMENT_ID);
+    ASSERT_EQ(follower.max_length(), 100u);
+    ASSERT_EQ(follower.arena_size(), 1000u);
+    ASSERT_THROW(
+        (MultiprocessTimeSeries<std::string, SingleSegment>::create_follower(
+            SEGMENT_ID)),
+        std::runtime_error);
+
+    leader.append("a");
+    leader.append(std::string(500, 'b'));
+    leader.append("");
+    ASSERT_EQ(follower[0], "a");
+    ASSERT_EQ(follower[1], std::string(500, 'b'));
+    ASSERT_EQ(follower[2], "");
+    ASSERT_EQ(follower.length(), 3u);
+    follower.visit(1, [](std::string_view payload) {
+        ASSERT_EQ(payload.size(), 500u);
+        ASSERT_EQ(payload[499], 'b');
+    });
+
+    // does not fit before the end of the arena: written at its beginning,
+    // overwriting the payloads of the previous elements
+    leader.append(std::string(600, 'c'));
+    ASSERT_EQ(follower.oldest_timeindex(), 3);
+    ASSERT_EQ(follower.length(), 1u);
+    ASSERT_THROW(follower[1], std::invalid_argument);
+    ASSERT_EQ(follower[3], std::string(600, 'c'));
+
+    ASSERT_THROW(leader.append(std::string(1001, 'd')), std::invalid_argument);
+    ASSERT_EQ(follower.newest_timeindex(), 3);
+
+    // many small payloads: dropped by max_length
+    for (int i = 0; i < 200; i++)
+    {
+        leader.append(std::to_string(i));
+    }
+    ASSERT_EQ(follower.length(), 100u);
+    ASSERT_EQ(follower.newest_element(), "199");
+    ASSERT_EQ(follower[follower.oldest_timeindex()], "100");
+}
+
+TEST(time_series_ut, compressed)
+{
+    ASSERT_THROW(CompressedTimeSeries<double>(10, 20), std::invalid_argument);
+
+    CompressedTimeSeries<double> ts(1000, 100, 10);
+    ASSERT_TRUE(ts.is_empty());
+    std::vector<double> values;
+    for (int i = 0; i < 2550; i++)
+    {
+        values.push_back(std::sin(i * 0.001) + (i % 7 == 0 ? 1e-9 : 0));
+        ts.append(values.back());
+    }
+    ASSERT_EQ(ts.newest_timeindex(), 2559);
+    // dropped by whole blocks
+    ASSERT_EQ(ts.oldest_timeindex(), 1610);
+    ASSERT_EQ(ts.length(), 950u);
+    ASSERT_THROW(ts[1609], std::invalid_argument);
+    // sealed blocks and hot block
+    for (Index index = 1610; index < 2560; index++)
+    {
+        ASSERT_EQ(ts[index], values[index - 10]);
+    }
+    ASSERT_EQ(ts.newest_element(), values.back());
+    ASSERT_LE(ts.timestamp_ms(1610), ts.timestamp_ms(2559));
+
+    Index expected = 1650;
+    int nb_chunks = 0;
+    std::vector<Timestamp> timestamps;
+    ts.visit_range(1650,
+                   2520,
+                   [&](const double *elements,
+                       const Timestamp *chunk_timestamps,
+                       std::size_t nb_elements) {
+                       for (std::size_t i = 0; i < nb_elements; i++)
+                       {
+                           ASSERT_EQ(elements[i], values[expected - 10]);
+                           timestamps.push_back(chunk_timestamps[i]);
+                           expected++;
+                       }
+                       nb_chunks++;
+                   });
+    ASSERT_EQ(expected, 2521);
+    ASSERT_EQ(nb_chunks, 10);
+    for (Index index = 1650; index <= 2520; index++)
+    {
+        ASSERT_EQ(timestamps[index - 1650], ts.timestamp_ms(index));
+    }
+}
+
+// restores the cpu affinity and the scheduling policy of the calling
+// thread on destruction
+struct SchedulingGuard
+{
+    SchedulingGuard()
+    {
+        pthread_getaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        pthread_getschedparam(pthread_self(), &policy, &param);
+    }
+    ~SchedulingGuard()
+    {
+        pthread_setschedparam(pthread_self(), policy, &param);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    }
+    // first cpu the thread may run on
+    int first_cpu() const
+    {
+        int cpu = 0;
+        while (!CPU_ISSET(cpu, &cpus))
+        {
+            cpu++;
+        }
+        return cpu;
+    }
+    cpu_set_t cpus;
+    int policy;
+    sched_param param;
+};
+
+static void pin_on_cpu(int cpu)
+{
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+}
+
+// read(ts, index) of an element dropped while the reader waits for it.
+// The reader runs on the same cpu as the appends, with the SCHED_IDLE
+// policy: it is woken up only once all the appends are done.
+template <typename F>
+static void read_dropped_while_waiting(F read)
+{
+    SchedulingGuard guard;
+    int cpu = guard.first_cpu();
+    pin_on_cpu(cpu);
+    CompressedTimeSeries<int> ts(20, 10);
+    std::atomic<bool> started(false);
+    bool too_old = false;
+    int value = -1;
+    std::thread reader([&]() {
+        pin_on_cpu(cpu);
+        sched_param param;
+        param.sched_priority = 0;
+        pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+        started = true;
+        try
+        {
+            value = read(ts, 5);
+        }
+        catch (const std::invalid_argument &)
+        {
+            too_old = true;
+        }
+    });
+    while (!started)
+    {
+        usleep(1000);
+    }
+    usleep(20000);
+    for (int i = 0; i < 100; i++)
+    {
+        ts.append(i);
+    }
+    reader.join();
+    ASSERT_GT(ts.oldest_timeindex(), 5);
+    // read before being dropped, or reported as too old
+    ASSERT_TRUE(too_old || value == 5);
+}
+
+TEST(time_series_ut, compressed_dropped_while_waiting)
+{
+    read_dropped_while_waiting(
+        [](const CompressedTimeSeries<int> &ts, Index index) {
+            return ts[index];
+        });
+    read_dropped_while_waiting(
+        [](const CompressedTimeSeries<int> &ts, Index index) {
+            return ts.at(index).element;
+        });
+}
+
+TEST(time_series_ut, compressed_eigen)
+{
+    typedef Eigen::Vector3d Vector;
+    size_t max_length = 100000;
+    CompressedTimeSeries<Vector> ts(max_length, 1000);
+    for (size_t i = 0; i < max_length; i++)
+    {
+        // slowly varying (e.g. robot joints)
+        ts.append(Vector(1.0, 0.5, static_cast<double>(i / 100)));
+    }
+    ASSERT_EQ(ts[0], Vector(1.0, 0.5, 0.0));
+    ASSERT_EQ(ts[54321], Vector(1.0, 0.5, 543.0));
+    std::size_t raw = max_length * (sizeof(Vector) + sizeof(Timestamp));
+    ASSERT_LT(ts.memory_usage(), raw / 4);
+}
+
+TEST(time_series_ut, policies)
+{
+    typedef TimeSeriesPolicies<NoTimestamps, PollingWait<50>, FixedCapacity<64>>
+        Lean;
+    ASSERT_THROW((TimeSeries<double, Lean>(100)), std::invalid_argument);
+    TimeSeries<double, Lean> ts(64);
+    ASSERT_EQ(ts.max_length(), 64u);
+    ASSERT_FALSE(ts.wait_for_timeindex(0, 0.001));
+    for (int i = 0; i < 100; i++)
+    {
+        ts.append(i);
+    }
+    ASSERT_EQ(ts.oldest_timeindex(), 36);
+    ASSERT_EQ(ts[99], 99.);
+    ASSERT_EQ(ts[36], 36.);
+    ASSERT_THROW(ts.timestamp_ms(99), std::logic_error);
+    // polling readers (never notified)
+    std::thread reader([&ts]() { ASSERT_EQ(ts[100], 100.); });
+    usleep(2000);
+    ts.append(100);
+    reader.join();
+
+    TimeSeries<double, TimeSeriesPolicies<MonotonicClock>> monotonic(10);
+    monotonic.append(1.);
+    monotonic.append(2.);
+    ASSERT_LE(monotonic.timestamp_ms(0), monotonic.timestamp_ms(1));
+
+    clear_memory(SEGMENT_ID);
+    typedef MultiprocessTimeSeries<int, SingleSegment, Lean> Mpt;
+    Mpt leader = Mpt::create_leader(SEGMENT_ID, 64);
+    Mpt follower = Mpt::create_follower(SEGMENT_ID);
+    leader.append(10);
+    ASSERT_EQ(follower[0], 10);
+    ASSERT_THROW(follower.timestamp_ms(0), std::logic_error);
+    // no memory reserved for the timestamps
+    std::shared_ptr<internal::Segment> segment =
+        internal::Segment::inspect(SEGMENT_ID);
+    ASSERT_EQ(segment->header()->timestamps_offset,
+              segment->header()->slots_offset);
+    typedef MultiprocessTimeSeries<int, SingleSegment> Timestamped;
+    ASSERT_THROW(Timestamped::create_follower(SEGMENT_ID), std::runtime_error);
+}
+
+TEST(time_series_ut, samples)
+{
+    TimeSeries<int> ts(10);
+    ts.append(1);
+    ts.append(2);
+    Sample<int> newest = ts.newest();
+    ASSERT_EQ(newest.index, 1);
+    ASSERT_EQ(newest.element, 2);
+    ASSERT_EQ(newest.timestamp, ts.timestamp_ms(1));
+    Sample<int> first = ts.at(0);
+    ASSERT_EQ(first.element, 1);
+    ASSERT_EQ(first.timestamp, ts.timestamp_ms(0));
+
+    TimeSeries<int, TimeSeriesPolicies<NoTimestamps>> no_timestamps(10);
+    no_timestamps.append(3);
+    ASSERT_EQ(no_timestamps.newest().element, 3);
+    ASSERT_TRUE(std::isnan(no_timestamps.newest().timestamp));
+
+    clear_memory(SEGMENT_ID);
+    typedef MultiprocessTimeSeries<int> Mpt;
+    Mpt leader = Mpt::create_leader(SEGMENT_ID, 2);
+    Mpt follower = Mpt::create_follower(SEGMENT_ID);
+    for (int i = 0; i < 5; i++)
+    {
+        leader.append(i);
+    }
+    ASSERT_EQ(follower.newest().element, 4);
+    ASSERT_EQ(follower.at(3).element, 3);
+    ASSERT_THROW(follower.at(2), std::invalid_argument);
+
+    MultiProducerTimeSeries<int> multi_producer(10);
+    multi_producer.append(5);
+    ASSERT_EQ(multi_producer.newest().element, 5);
+    ASSERT_EQ(multi_producer.at(0).timestamp, multi_producer.timestamp_ms(0));
+
+    CompressedTimeSeries<int> compressed(10, 2);
+    for (int i = 0; i < 5; i++)
+    {
+        compressed.append(i);
+    }
+    ASSERT_EQ(compressed.newest().index, 4);
+    ASSERT_EQ(compressed.at(1).element, 1);
+    ASSERT_EQ(compressed.at(1).timestamp, compressed.timestamp_ms(1));
+}
+
+TEST(time_series_ut, when_available)
+{
+    TimeSeries<int> ts(10);
+    ts.append(0);
+    int called = 0;
+    ASSERT_FALSE(ts.when_available(0, [&called]() { called++; }));
+    ASSERT_TRUE(ts.when_available(2, [&called]() { called++; }));
+    ASSERT_TRUE(ts.when_available(1, [&called]() { called++; }));
+    ts.append(1);
+    ASSERT_EQ(called, 1);
+    ts.append(2);
+    ASSERT_EQ(called, 2);
+    ts.append(3);
+    ASSERT_EQ(called, 2);
+
+    // callbacks registered concurrently to appends are all called once
+    TimeSeries<int> concurrent(1000);
+    std::atomic<int> count(0);
+    std::thread producer([&concurrent]() {
+        for (int i = 0; i < 500; i++)
+        {
+            concurrent.append(i);
+        }
+    });
+    int registered = 0;
+    for (Index index = 0; index < 500; index++)
+    {
+        if (concurrent.when_available(index, [&count]() { count++; }))
+        {
+            registered++;
+        }
+    }
+    producer.join();
+    ASSERT_EQ(count.load(), registered);
+}
+
+TEST(time_series_ut, reactor)
+{
+    clear_memory(SEGMENT_ID);
+    typedef MultiprocessTimeSeries<int> Mpt;
+    Mpt leader = Mpt::create_leader(SEGMENT_ID, 10);
+    Mpt follower = Mpt::create_follower(SEGMENT_ID);
+    Reactor reactor;
+    std::atomic<int> called(0);
+    ASSERT_TRUE(reactor.when_available(follower, 1, [&called]() { called++; }));
+    ASSERT_EQ(reactor.pending(), 1);
+    leader.append(0);
+    leader.append(1);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (called.load() == 0 && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ(called.load(), 1);
+    ASSERT_EQ(reactor.pending(), 0);
+    ASSERT_FALSE(reactor.when_available(follower, 1, [&called]() { called++; }));
+}
+
+// true if fd becomes readable within timeout_ms (and resets it)
+static bool readable(int fd, int timeout_ms)
+{
+    pollfd pfd{fd, POLLIN, 0};
+    if (poll(&pfd, 1, timeout_ms) != 1)
+    {
+        return false;
+    }
+    std::uint64_t counter;
+    return read(fd, &counter, sizeof(counter)) == sizeof(counter);
+}
+
+TEST(time_series_ut, event_fd)
+{
+    TimeSeries<int> ts(10);
+    ts.append(0);
+    int fd = ts.event_fd();
+    ASSERT_EQ(ts.event_fd(), fd);
+    ASSERT_FALSE(readable(fd, 0));
+    ts.append(1);
+    ts.append(2);
+    ASSERT_TRUE(readable(fd, 0));
+    ASSERT_FALSE(readable(fd, 0));
+
+    clear_memory(SEGMENT_ID);
+    typedef MultiprocessTimeSeries<int> Mpt;
+    Mpt leader = Mpt::create_leader(SEGMENT_ID, 10);
+    Mpt follower = Mpt::create_follower(SEGMENT_ID);
+    Reactor reactor;
+    int follower_fd = reactor.event_fd(follower);
+    ASSERT_FALSE(readable(follower_fd, 10));
+    leader.append(0);
+    ASSERT_TRUE(readable(follower_fd, 1000));
+    ASSERT_FALSE(readable(follower_fd, 10));
+    reactor.remove_event_fd(follower_fd);
+}
+
+TEST(time_series_ut, subscribe)
+{
+    WorkerPool pool(4);
+    TimeSeries<int> ts(100);
+    ts.append(-1);
+
+    // in order, each element once, never in the appending thread
+    std::vector<int> values;
+    std::atomic<bool> inline_call(false);
+    std::thread::id appender = std::this_thread::get_id();
+    Subscription ordered = ts.subscribe(
+        [&](const Sample<int>& sample) {
+            values.push_back(sample.element);
+            if (std::this_thread::get_id() == appender)
+            {
+                inline_call = true;
+            }
+        },
+        pool.executor());
+
+    // slow subscriber with a small backlog: elements get dropped
+    std::atomic<int> batches(0);
+    Subscription slow = ts.subscribe_batch(
+        [&batches](const std::vector<Sample<int>>&) {
+            batches++;
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        },
+        pool.executor(),
+        5);
+
+    for (int i = 0; i < 200; i++)
+    {
+        ts.append(i);
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while ((ordered.delivered() < 200 ||
+            slow.delivered() + slow.dropped() < 200) &&
+           std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ(ordered.delivered(), 200u);
+    ASSERT_EQ(ordered.dropped(), 0u);
+    ASSERT_FALSE(inline_call.load());
+    for (int i = 0; i < 200; i++)
+    {
+        ASSERT_EQ(values[i], i);
+    }
+    ASSERT_GT(slow.dropped(), 0u);
+    ASSERT_EQ(slow.delivered() + slow.dropped(), 200u);
+    ASSERT_LT(batches.load(), 200);
+
+    // no delivery after cancel
+    ordered.cancel();
+    ts.append(200);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_EQ(ordered.delivered(), 200u);
+
+    ASSERT_THROW(ts.subscribe([](const Sample<int>&) {}, pool.executor(), 0),
+                 std::invalid_argument);
+
+    // drain task discarded by the executor: the next append posts another
+    bool discard = true;
+    Subscription resumed = ts.subscribe(
+        [](const Sample<int>&) {},
+        [&discard, &pool](std::function<void()> task) {
+            if (!discard)
+            {
+                pool.post(std::move(task));
+            }
+        });
+    ts.append(201);
+    discard = false;
+    ts.append(202);
+    deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (resumed.delivered() < 2 &&
+           std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ(resumed.delivered(), 2u);
+}
+
+// waits (up to 2 seconds) for the condition to become true
+template <typename F>
+static bool eventually(F condition)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (!condition() && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return condition();
+}
+
+TEST(time_series_ut, stream_bridge)
+{
+    // tcp loopback, leader to local time series
+    clear_memory(SEGMENT_ID);
+    typedef MultiprocessTimeSeries<int> Mpt;
+    Mpt leader = Mpt::create_leader(SEGMENT_ID, 100);
+    Mpt follower = Mpt::create_follower(SEGMENT_ID);
+    for (int i = 0; i < 10; i++)
+    {
+        leader.append(i);
+    }
+    {
+        StreamPublisher<Mpt> publisher(
+            follower, StreamEndpoint::tcp(0), 4, true);
+        TimeSeries<int> local(100);
+        StreamSubscriber<int> subscriber(
+            local, StreamEndpoint::tcp("127.0.0.1", publisher.port()));
+        for (int i = 10; i < 50; i++)
+        {
+            leader.append(i);
+        }
+        ASSERT_TRUE(eventually([&]() { return subscriber.received() == 50; }));
+        for (int i = 0; i < 50; i++)
+        {
+            ASSERT_EQ(local[i], i);
+        }
+        ASSERT_EQ(subscriber.last_index(), 49);
+        ASSERT_EQ(subscriber.last_timestamp_ms(),
+                  static_cast<double>(leader.timestamp_ms(49)));
+        ASSERT_EQ(subscriber.missed(), 0u);
+        ASSERT_EQ(publisher.sent(), 50u);
+
+        // element type mismatch
+        TimeSeries<double> doubles(10);
+        ASSERT_THROW(StreamSubscriber<double>(
+                         doubles, StreamEndpoint::tcp(publisher.port())),
+                     std::runtime_error);
+    }
+
+    // tcp, all interfaces (explicitly), raw (not serializable) elements
+    {
+        struct Point
+        {
+            double x, y;
+        };
+        TimeSeries<Point> points(10);
+        StreamPublisher<TimeSeries<Point>> publisher(
+            points, StreamEndpoint::tcp_all_interfaces(0));
+        TimeSeries<Point> local(10);
+        StreamSubscriber<Point> subscriber(
+            local, StreamEndpoint::tcp(publisher.port()));
+        points.append(Point{1., 2.});
+        ASSERT_TRUE(eventually([&]() { return subscriber.received() == 1; }));
+        ASSERT_EQ(local.newest_element().y, 2.);
+    }
+
+    // unix domain socket, serialized elements, disconnection
+    TimeSeries<SerializedType> source(10);
+    TimeSeries<SerializedType> local(10);
+    std::string path = "/tmp/" SEGMENT_ID ".sock";
+    auto publisher =
+        std::make_unique<StreamPublisher<TimeSeries<SerializedType>>>(
+            source, StreamEndpoint::unix_socket(path));
+    StreamSubscriber<SerializedType> subscriber(
+        local, StreamEndpoint::unix_socket(path));
+    ASSERT_EQ(publisher->connections(), 1u);
+    SerializedType element;
+    source.append(element);
+    ASSERT_TRUE(eventually([&]() { return subscriber.received() == 1; }));
+    ASSERT_TRUE(local.newest_element() == element);
+    ASSERT_TRUE(subscriber.connected());
+
+    // reconnections: the sockets of the disconnected subscribers are closed
+    auto nb_fds = []() {
+        std::filesystem::directory_iterator fds("/proc/self/fd");
+        return std::distance(fds, std::filesystem::directory_iterator());
+    };
+    auto fds = nb_fds();
+    for (int i = 0; i < 5; i++)
+    {
+        StreamSubscriber<SerializedType> transient(
+            local, StreamEndpoint::unix_socket(path));
+    }
+    ASSERT_TRUE(eventually([&]() { return publisher->connections() == 1; }));
+    ASSERT_TRUE(eventually([&]() { return nb_fds() == fds; }));
+
+    publisher.reset();
+    ASSERT_TRUE(eventually([&]() { return !subscriber.connected(); }));
+}
+
+// accepts a subscriber, sends the handshake for T and the bytes
+template <typename T>
+static void publish_raw(int listen_fd, const std::string& bytes)
+{
+    int fd = internal::accept_connection(listen_fd);
+    std::string frame;
+    internal::StreamCodec<T>::append(frame, internal::STREAM_MAGIC);
+    internal::StreamCodec<T>::append(frame, internal::STREAM_VERSION);
+    internal::StreamCodec<T>::append(frame, internal::type_hash<T>());
+    frame.append(bytes);
+    internal::send_all(fd, frame.data(), frame.size());
+    // (waiting for the subscriber to close the connection)
+    char byte;
+    internal::receive_all(fd, &byte, 1);
+    internal::close_socket(fd);
+}
+
+TEST(time_series_ut, stream_bridge_invalid_frames)
+{
+    std::string path = "/tmp/" SEGMENT_ID ".sock";
+    typedef internal::StreamCodec<int> Codec;
+    std::string header;
+    Codec::append(header, internal::FRAME_MAGIC);
+    Codec::append(header, std::uint32_t(1));
+    Codec::append(header, std::int64_t(0));
+    Codec::append(header, double(0));
+
+    // element size larger than any element: rejected before allocating
+    std::string huge = header;
+    Codec::append(huge, std::uint32_t(4000000000u));
+    // element which fails to decode
+    std::string truncated = header;
+    Codec::append(truncated, std::uint32_t(2));
+    truncated.append(2, 'a');
+    // not a frame
+    std::string invalid;
+    Codec::append(invalid, std::uint32_t(0));
+
+    for (const std::string& bytes : {huge, truncated, invalid})
+    {
+        int listen_fd = internal::listen_unix(path);
+        std::thread publisher(publish_raw<int>, listen_fd, bytes);
+        TimeSeries<int> local(10);
+        StreamSubscriber<int> subscriber(local,
+                                         StreamEndpoint::unix_socket(path));
+        ASSERT_TRUE(eventually([&]() { return !subscriber.connected(); }));
+        ASSERT_FALSE(subscriber.error().empty());
+        ASSERT_EQ(subscriber.received(), 0u);
+        ASSERT_TRUE(local.is_empty());
+        publisher.join();
+        internal::close_socket(listen_fd);
+    }
+}
+
+TEST(time_series_ut, mapped)
+{
+    TimeSeries<Eigen::Vector3d> forces(10);
+    int calls = 0;
+    auto norms = map_view(forces, [&calls](const Eigen::Vector3d& force) {
+        calls++;
+        return force.norm();
+    });
+    ASSERT_TRUE(norms.is_empty());
+    ASSERT_THROW(norms.append(0.), std::logic_error);
+
+    forces.append(Eigen::Vector3d(3., 4., 0.));
+    forces.append(Eigen::Vector3d(0., 0., 2.));
+    ASSERT_EQ(calls, 0);
+    ASSERT_EQ(norms.newest_timeindex(), 1);
+    ASSERT_EQ(norms.length(), 2u);
+    ASSERT_DOUBLE_EQ(norms[0], 5.);
+    ASSERT_DOUBLE_EQ(norms.newest_element(), 2.);
+    ASSERT_DOUBLE_EQ(norms.newest_element(), 2.);
+    // (memoized)
+    ASSERT_EQ(calls, 2);
+    ASSERT_EQ(norms.timestamp_ms(1), forces.timestamp_ms(1));
+
+    ASSERT_TRUE(norms.has_changed_since_tag());
+    Index source_tag = forces.tagged_timeindex();
+    norms.tag(1);
+    ASSERT_FALSE(norms.has_changed_since_tag());
+    ASSERT_EQ(forces.tagged_timeindex(), source_tag);
+
+    // views of views, and waits forwarded to the source
+    MappedTimeSeries<bool, double> large(
+        norms, [](double norm) { return norm > 3.; }, false);
+    ASSERT_TRUE(large[0]);
+    ASSERT_FALSE(large[1]);
+    std::thread producer([&forces]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        forces.append(Eigen::Vector3d(10., 0., 0.));
+    });
+    ASSERT_TRUE(large[2]);
+    producer.join();
+}
+
+// clock policy returning a timestamp set by the test
+struct ManualClock
+{
+    static constexpr bool timestamps = true;
+    static Timestamp now_ms()
+    {
+        return time_ms;
+    }
+    static Timestamp time_ms;
+};
+Timestamp ManualClock::time_ms = 0;
+
+template <typename T>
+using ManualClockTimeSeries = TimeSeries<T, TimeSeriesPolicies<ManualClock>>;
+typedef ManualClockTimeSeries<int> ManualTimeSeries;
+
+// appends the value to ts with the timestamp
+template <typename T>
+static void append_at(ManualClockTimeSeries<T>& ts,
+                      const T& value,
+                      Timestamp time_ms)
+{
+    ManualClock::time_ms = time_ms;
+    ts.append(value);
+}
+
+TEST(time_series_ut, timestamp_join)
+{
+    ManualTimeSeries imu(100);
+    ManualTimeSeries encoders(100);
+    append_at(encoders, 0, 0.);
+    append_at(imu, 10, 1.);
+    append_at(encoders, 1, 10.);
+    append_at(imu, 11, 8.);
+    append_at(imu, 12, 30.);
+    append_at(imu, 13, 41.);
+
+    auto nearest = make_timestamp_join(JoinMethod::NEAREST,
+                                       std::numeric_limits<double>::infinity(),
+                                       imu,
+                                       encoders);
+    auto previous = make_timestamp_join(
+        JoinMethod::PREVIOUS, 10., imu, encoders);
+    auto exact = make_timestamp_join(JoinMethod::EXACT, 2., imu, encoders);
+
+    // imu 30 and 41 wait for newer encoder samples
+    auto tuples = nearest.poll();
+    ASSERT_EQ(tuples.size(), 2u);
+    ASSERT_EQ(std::get<0>(tuples[0]).element, 10);
+    ASSERT_EQ(std::get<1>(tuples[0]).element, 0);
+    ASSERT_EQ(std::get<1>(tuples[1]).element, 1);
+    ASSERT_EQ(std::get<1>(tuples[1]).timestamp, 10.);
+
+    tuples = previous.poll();
+    ASSERT_EQ(tuples.size(), 2u);
+    ASSERT_EQ(std::get<1>(tuples[0]).element, 0);
+    ASSERT_EQ(std::get<1>(tuples[1]).element, 0);
+
+    // 1 matches 0. 8 may match 10, unless a nearer encoder sample comes
+    tuples = exact.poll();
+    ASSERT_EQ(tuples.size(), 1u);
+    ASSERT_EQ(std::get<1>(tuples[0]).element, 0);
+
+    // incremental (41 waits for an encoder sample after 41)
+    append_at(encoders, 2, 40.);
+    tuples = nearest.poll();
+    ASSERT_EQ(tuples.size(), 1u);
+    ASSERT_EQ(std::get<0>(tuples[0]).element, 12);
+    ASSERT_EQ(std::get<1>(tuples[0]).element, 2);
+    ASSERT_TRUE(nearest.poll().empty());
+
+    // 30: previous is 10, out of tolerance. 41 waits for newer encoders
+    tuples = previous.poll();
+    ASSERT_EQ(tuples.size(), 0u);
+    ASSERT_EQ(previous.unmatched(), 1u);
+    append_at(encoders, 3, 50.);
+    tuples = previous.poll();
+    ASSERT_EQ(tuples.size(), 1u);
+    ASSERT_EQ(std::get<1>(tuples[0]).element, 2);
+
+    tuples = nearest.poll();
+    ASSERT_EQ(tuples.size(), 1u);
+    ASSERT_EQ(std::get<0>(tuples[0]).element, 13);
+    ASSERT_EQ(std::get<1>(tuples[0]).element, 2);
+
+    // 8: 10, 30: no encoder within 2 ms, 41: 40
+    tuples = exact.poll();
+    ASSERT_EQ(tuples.size(), 2u);
+    ASSERT_EQ(std::get<0>(tuples[0]).element, 11);
+    ASSERT_EQ(std::get<1>(tuples[0]).element, 1);
+    ASSERT_EQ(std::get<0>(tuples[1]).element, 13);
+    ASSERT_EQ(std::get<1>(tuples[1]).element, 2);
+    ASSERT_EQ(exact.unmatched(), 1u);
+
+    // three series
+    ManualTimeSeries other(100);
+    append_at(other, 100, 0.);
+    append_at(other, 101, 100.);
+    auto three = make_timestamp_join(
+        JoinMethod::PREVIOUS, 100., imu, encoders, other);
+    ASSERT_EQ(three.poll().size(), 4u);
+
+    ASSERT_THROW(make_timestamp_join(JoinMethod::EXACT,
+                                     std::numeric_limits<double>::infinity(),
+                                     imu,
+                                     encoders),
+                 std::invalid_argument);
+}
+
+TEST(time_series_ut, timestamp_join_stalled)
+{
+    ManualTimeSeries imu(10);
+    ManualTimeSeries encoders(10);
+    auto join = make_timestamp_join(JoinMethod::PREVIOUS, 100., imu, encoders);
+    // imu stalled: the buffered encoder samples are capped to 10
+    for (int i = 0; i < 100; i++)
+    {
+        append_at(encoders, i, i);
+        ASSERT_TRUE(join.poll().empty());
+    }
+    ASSERT_EQ(join.dropped(), 90u);
+    // encoder samples dropped from the time series before being polled
+    for (int i = 100; i < 120; i++)
+    {
+        append_at(encoders, i, i);
+    }
+    ASSERT_TRUE(join.poll().empty());
+    ASSERT_EQ(join.dropped(), 110u);
+    append_at(imu, 0, 115.5);
+    auto tuples = join.poll();
+    ASSERT_EQ(tuples.size(), 1u);
+    ASSERT_EQ(std::get<1>(tuples[0]).element, 115);
+
+    // backlog longer than a fetch chunk
+    std::size_t length = 2 * decltype(join)::FETCH_CHUNK + 10;
+    ManualTimeSeries left(length);
+    ManualTimeSeries right(length);
+    for (std::size_t i = 0; i < length; i++)
+    {
+        append_at(left, static_cast<int>(i), i);
+        append_at(right, static_cast<int>(i), i);
+    }
+    auto backlog =
+        make_timestamp_join(JoinMethod::EXACT, 0., left, right);
+    tuples = backlog.poll();
+    ASSERT_EQ(tuples.size(), length);
+    for (std::size_t i = 0; i < tuples.size(); i++)
+    {
+        ASSERT_EQ(std::get<0>(tuples[i]).element, static_cast<int>(i));
+        ASSERT_EQ(std::get<1>(tuples[i]).element, static_cast<int>(i));
+    }
+    ASSERT_EQ(backlog.dropped(), 0u);
+}
+
+TEST(time_series_ut, value_at_time)
+{
+    ManualClockTimeSeries<double> values(3);
+    append_at(values, 0., 10.);
+    append_at(values, 10., 20.);
+    append_at(values, 30., 30.);
+    ASSERT_DOUBLE_EQ(values.value_at_time(15.), 5.);
+    ASSERT_DOUBLE_EQ(values.value_at_time(25.), 20.);
+    ASSERT_DOUBLE_EQ(values.value_at_time(20.), 10.);
+    ASSERT_DOUBLE_EQ(values.value_at_time(10.), 0.);
+    ASSERT_DOUBLE_EQ(
+        values.value_at_time(29., Interpolation::ZERO_ORDER_HOLD), 10.);
+    // no extrapolation
+    ASSERT_DOUBLE_EQ(values.value_at_time(100.), 30.);
+    ASSERT_THROW(values.value_at_time(5.), std::invalid_argument);
+    ASSERT_THROW(values.value_at_time(15., Interpolation::SLERP),
+                 std::invalid_argument);
+    // (ring wrapped)
+    append_at(values, 40., 40.);
+    ASSERT_DOUBLE_EQ(values.value_at_time(35.), 35.);
+    ASSERT_THROW(values.value_at_time(15.), std::invalid_argument);
+
+    ManualClockTimeSeries<int> integers(10);
+    append_at(integers, 0, 0.);
+    append_at(integers, 10, 10.);
+    ASSERT_EQ(integers.value_at_time(5.), 5);
+    // decreasing unsigned values (rounded)
+    ManualClockTimeSeries<unsigned> decreasing(10);
+    append_at(decreasing, 10u, 0.);
+    append_at(decreasing, 5u, 10.);
+    ASSERT_EQ(decreasing.value_at_time(5.), 8u);
+    ASSERT_EQ(decreasing.value_at_time(8.), 6u);
+    // exact beyond 2^53, and over the whole range of the type
+    ManualClockTimeSeries<std::uint64_t> large(10);
+    append_at(large, std::uint64_t(0), 0.);
+    append_at(large, std::numeric_limits<std::uint64_t>::max(), 4.);
+    ASSERT_EQ(large.value_at_time(2.), std::uint64_t(1) << 63);
+    ManualClockTimeSeries<std::int64_t> signed_large(10);
+    append_at(signed_large, (std::int64_t(1) << 60) + 1, 0.);
+    append_at(signed_large, std::numeric_limits<std::int64_t>::min(), 1.);
+    ASSERT_EQ(signed_large.value_at_time(0.), (std::int64_t(1) << 60) + 1);
+    ManualClockTimeSeries<std::int8_t> bytes(10);
+    append_at(bytes, std::int8_t(-128), 0.);
+    append_at(bytes, std::int8_t(127), 1.);
+    ASSERT_EQ(bytes.value_at_time(0.5), 0);
+    // (alpha would be truncated to 0 in the integer scalar)
+    ManualClockTimeSeries<Eigen::Vector3i> integer_vectors(10);
+    append_at(integer_vectors, Eigen::Vector3i(0, 0, 0), 0.);
+    append_at(integer_vectors, Eigen::Vector3i(2, 4, 6), 2.);
+    ASSERT_THROW(integer_vectors.value_at_time(1.), std::invalid_argument);
+
+    ManualClockTimeSeries<Eigen::Vector3f> vectors(10);
+    append_at(vectors, Eigen::Vector3f(0.f, 0.f, 0.f), 0.);
+    append_at(vectors, Eigen::Vector3f(2.f, 4.f, 6.f), 2.);
+    ASSERT_TRUE(vectors.value_at_time(1.).isApprox(Eigen::Vector3f(1., 2., 3.)));
+
+    ManualClockTimeSeries<Eigen::Quaterniond> orientations(10);
+    append_at(orientations, Eigen::Quaterniond::Identity(), 0.);
+    append_at(orientations,
+              Eigen::Quaterniond(
+                  Eigen::AngleAxisd(M_PI / 2., Eigen::Vector3d::UnitZ())),
+              1.);
+    Eigen::Quaterniond half =
+        orientations.value_at_time(0.5, Interpolation::SLERP);
+    ASSERT_TRUE(half.isApprox(Eigen::Quaterniond(
+        Eigen::AngleAxisd(M_PI / 4., Eigen::Vector3d::UnitZ()))));
+    ASSERT_THROW(orientations.value_at_time(0.5, Interpolation::LINEAR),
+                 std::invalid_argument);
+
+    TimeSeries<double, TimeSeriesPolicies<NoTimestamps>> no_timestamps(10);
+    no_timestamps.append(1.);
+    ASSERT_THROW(no_timestamps.value_at_time(0.), std::logic_error);
+
+    clear_memory(SEGMENT_ID);
+    typedef MultiprocessTimeSeries<double> Mpt;
+    Mpt leader = Mpt::create_leader(SEGMENT_ID, 10);
+    leader.append(1.);
+    leader.append(1.);
+    ASSERT_DOUBLE_EQ(leader.value_at_time(leader.timestamp_ms(1)), 1.);
+}
+
+TEST(time_series_ut, reattach_leader)
+{
+    clear_memory(SEGMENT_ID);
+    typedef MultiprocessTimeSeries<int, SingleSegment> Mpt;
+    ASSERT_THROW(Mpt::reattach_leader(SEGMENT_ID), std::runtime_error);
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        // leader crashing while holding the mutex
+        Mpt leader = Mpt::create_leader(SEGMENT_ID, 10);
+        for (int value = 0; value < 5; value++)
+        {
+            leader.append(value);
+        }
+        std::shared_ptr<internal::Segment> segment =
+            internal::Segment::attach(SEGMENT_ID, internal::type_hash<int>());
+        pthread_mutex_lock(&segment->header()->mutex);
+        _exit(0);
+    }
+    ASSERT_EQ(waitpid(pid, nullptr, 0), pid);
+    {
+        Mpt leader = Mpt::reattach_leader(SEGMENT_ID);
+        Mpt follower = Mpt::create_follower(SEGMENT_ID);
+        ASSERT_EQ(follower.newest_timeindex(), 4);
+        ASSERT_EQ(follower[4], 4);
+        leader.append(5);
+        ASSERT_EQ(follower.newest_timeindex(), 5);
+        ASSERT_EQ(follower[5], 5);
+        ASSERT_EQ(follower.oldest_timeindex(), 0);
+    }
+    // segment wiped by the new leader
+    ASSERT_THROW(Mpt::create_follower(SEGMENT_ID), std::runtime_error);
+}
+
+TEST(time_series_ut, recover_interrupted_append)
+{
+    clear_memory(SEGMENT_ID);
+    typedef TimeSeriesPolicies<WallClock,
+                               BlockingWait,
+                               DynamicCapacity,
+                               TrackPeriod>
+        WallTracked;
+    typedef MultiprocessTimeSeries<int, SingleSegment, WallTracked> Mpt;
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        // leader crashing in the middle of appending 4 to a full ring:
+        // the element is written in the slot of the oldest element (1),
+        // the period statistics are being updated (odd sequence counter)
+        // and the indexes are not updated yet
+        Mpt leader = Mpt::create_leader(SEGMENT_ID, 3);
+        for (int value = 0; value < 4; value++)
+        {
+            leader.append(value);
+        }
+        std::shared_ptr<internal::Segment> segment =
+            internal::Segment::attach(SEGMENT_ID, internal::type_hash<int>());
+        pthread_mutex_lock(&segment->header()->mutex);
+        segment->header()->indexes.writing = true;
+        int element = 4;
+        std::memcpy(segment->slots() + (4 % 3) * segment->header()->slot_size,
+                    &element,
+                    sizeof(element));
+        segment->header()->period_tracker.sequence++;
+        _exit(0);
+    }
+    ASSERT_EQ(waitpid(pid, nullptr, 0), pid);
+    Mpt leader = Mpt::reattach_leader(SEGMENT_ID);
+    Mpt follower = Mpt::create_follower(SEGMENT_ID);
+    // (locking: recovery)
+    ASSERT_EQ(follower[3], 3);
+    ASSERT_EQ(follower.newest_timeindex(), 3);
+    ASSERT_EQ(follower.oldest_timeindex(), 2);
+    ASSERT_THROW(follower[1], std::invalid_argument);
+    ASSERT_EQ(follower[2], 2);
+    // (the statistics interrupted by the crash are reset)
+    ASSERT_EQ(follower.period_statistics().count, 0);
+    leader.append(4);
+    ASSERT_EQ(follower.oldest_timeindex(), 2);
+    ASSERT_EQ(follower[4], 4);
+    leader.append(5);
+    ASSERT_EQ(follower.period_statistics().count, 1);
+}
+
+TEST(time_series_ut, recover_dead_lock_holders)
+{
+    typedef MultiprocessTimeSeries<int, SingleSegment> Mpt;
+    // process dying while holding the lock, (not) appending
+    auto die_locked = [](bool appending) {
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            std::shared_ptr<internal::Segment> segment =
+                internal::Segment::attach(SEGMENT_ID,
+                                          internal::type_hash<int>());
+            pthread_mutex_lock(&segment->header()->mutex);
+            segment->header()->indexes.writing = appending;
+            _exit(0);
+        }
+        return waitpid(pid, nullptr, 0) == pid;
+    };
+
+    // reader (full ring): no element dropped
+    clear_memory(SEGMENT_ID);
+    {
+        Mpt leader = Mpt::create_leader(SEGMENT_ID, 3);
+        for (int value = 0; value < 4; value++)
+        {
+            leader.append(value);
+        }
+        ASSERT_TRUE(die_locked(false));
+        ASSERT_EQ(leader[1], 1);
+        ASSERT_EQ(leader.oldest_timeindex(), 1);
+        ASSERT_EQ(leader.newest_timeindex(), 3);
+    }
+
+    // writer, max length of 1: the only (maybe torn) element is dropped
+    clear_memory(SEGMENT_ID);
+    {
+        Mpt leader = Mpt::create_leader(SEGMENT_ID, 1);
+        leader.append(0);
+        leader.append(1);
+        ASSERT_TRUE(die_locked(true));
+        ASSERT_THROW(leader[1], std::invalid_argument);
+        ASSERT_EQ(leader.oldest_timeindex(), 2);
+        leader.append(2);
+        ASSERT_EQ(leader[2], 2);
+        ASSERT_EQ(leader.oldest_timeindex(), 2);
+    }
+}
+
+TEST(time_series_ut, mutex_not_recoverable)
+{
+    clear_memory(SEGMENT_ID);
+    typedef MultiprocessTimeSeries<int, SingleSegment> Mpt;
+    Mpt leader = Mpt::create_leader(SEGMENT_ID, 3);
+    leader.append(0);
+    std::shared_ptr<internal::Segment> segment =
+        internal::Segment::attach(SEGMENT_ID, internal::type_hash<int>());
+    pthread_mutex_t* mutex = &segment->header()->mutex;
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        pthread_mutex_lock(mutex);
+        _exit(0);
+    }
+    ASSERT_EQ(waitpid(pid, nullptr, 0), pid);
+    // released without restoring the consistency of the mutex
+    ASSERT_EQ(pthread_mutex_lock(mutex), EOWNERDEAD);
+    pthread_mutex_unlock(mutex);
+    ASSERT_THROW(leader.append(1), std::runtime_error);
+    ASSERT_THROW(leader[0], std::runtime_error);
+}
+
+TEST(time_series_ut, segment_monitor)
+{
+    clear_memory(SEGMENT_ID);
+    ASSERT_THROW(SegmentMonitor monitor(SEGMENT_ID), std::runtime_error);
+    {
+        typedef MultiprocessTimeSeries<Type, SingleSegment> Mpt;
+        Mpt leader = Mpt::create_leader(SEGMENT_ID, 3, 10);
+        std::vector<std::string> ids = SegmentMonitor::discover();
+        ASSERT_NE(std::find(ids.begin(), ids.end(), SEGMENT_ID), ids.end());
+        SegmentMonitor monitor(SEGMENT_ID);
+        SegmentStatus status = monitor.status();
+        ASSERT_TRUE(status.single_segment);
+        ASSERT_EQ(status.length(), 0);
+        ASSERT_EQ(status.max_length, 3);
+        ASSERT_EQ(status.leader_pid, getpid());
+        ASSERT_TRUE(status.leader_alive);
+        ASSERT_EQ(status.period.count, 0);
+        for (int i = 0; i < 5; i++)
+        {
+            leader.append(Type());
+        }
+        leader.tag(12);
+        status = monitor.status();
+        ASSERT_EQ(status.newest, 14);
+        ASSERT_EQ(status.oldest, 12);
+        ASSERT_EQ(status.tagged, 12);
+        ASSERT_EQ(status.length(), 3);
+    }
+    clear_memory(SEGMENT_ID);
+    {
+        typedef MultiprocessTimeSeries<int> Mpt;
+        Mpt leader = Mpt::create_leader(SEGMENT_ID, 10);
+        leader.append(1);
+        SegmentStatus status = SegmentMonitor(SEGMENT_ID).status();
+        ASSERT_FALSE(status.single_segment);
+        ASSERT_EQ(status.newest, 0);
+        ASSERT_EQ(status.length(), 1);
+        ASSERT_EQ(status.max_length, 10);
+        ASSERT_EQ(status.waiters, -1);
+    }
+}
+
+TEST(time_series_ut, period_statistics)
+{
+    typedef TimeSeriesPolicies<ManualClock,
+                               BlockingWait,
+                               DynamicCapacity,
+                               TrackPeriod>
+        Tracked;
+    TimeSeries<int, Tracked> ts(2);
+    ts.set_period_ewma_weight(0.5);
+    ts.set_period_deadline(15.);
+    ASSERT_EQ(ts.period_statistics().count, 0);
+    for (Timestamp time_ms : {0., 10., 20., 40.})
+    {
+        ManualClock::time_ms = time_ms;
+        ts.append(0);
+    }
+    PeriodStatistics statistics = ts.period_statistics();
+    ASSERT_EQ(statistics.count, 3);
+    ASSERT_DOUBLE_EQ(statistics.mean_ms, 15.);
+    ASSERT_DOUBLE_EQ(statistics.variance_ms2, 25.);
+    ASSERT_DOUBLE_EQ(statistics.stddev_ms(), 5.);
+    ASSERT_DOUBLE_EQ(statistics.min_ms, 10.);
+    ASSERT_DOUBLE_EQ(statistics.max_ms, 20.);
+    ASSERT_EQ(statistics.deadline_misses, 1);
+    ASSERT_DOUBLE_EQ(statistics.deadline_ms, 15.);
+    ts.reset_period_statistics();
+    ASSERT_EQ(ts.period_statistics().count, 0);
+    ManualClock::time_ms = 45.;
+    ts.append(0);
+    ASSERT_EQ(ts.period_statistics().count, 0);
+    ASSERT_THROW(ts.set_period_ewma_weight(0.), std::invalid_argument);
+    ASSERT_THROW(ts.set_period_deadline(-1.), std::invalid_argument);
+
+    TimeSeries<int> untracked(10);
+    ASSERT_THROW(untracked.period_statistics(), std::logic_error);
+
+    // shared by the processes
+    typedef TimeSeriesPolicies<WallClock,
+                               BlockingWait,
+                               DynamicCapacity,
+                               TrackPeriod>
+        WallTracked;
+    clear_memory(SEGMENT_ID);
+    {
+        typedef MultiprocessTimeSeries<int, SingleSegment, WallTracked> Mpt;
+        Mpt leader = Mpt::create_leader(SEGMENT_ID, 10);
+        Mpt follower = Mpt::create_follower(SEGMENT_ID);
+        follower.set_period_deadline(1e6);
+        for (int i = 0; i < 3; i++)
+        {
+            leader.append(i);
+        }
+        ASSERT_EQ(follower.period_statistics().count, 2);
+        ASSERT_EQ(SegmentMonitor(SEGMENT_ID).status().period.count, 2);
+        ASSERT_DOUBLE_EQ(leader.period_statistics().deadline_ms, 1e6);
+    }
+    clear_memory(SEGMENT_ID);
+    {
+        typedef MultiprocessTimeSeries<int, MultipleSegments, WallTracked> Mpt;
+        Mpt leader = Mpt::create_leader(SEGMENT_ID, 10);
+        Mpt follower = Mpt::create_follower(SEGMENT_ID);
+        for (int i = 0; i < 3; i++)
+        {
+            follower.append(i);
+        }
+        ASSERT_EQ(leader.period_statistics().count, 2);
+        ASSERT_EQ(SegmentMonitor(SEGMENT_ID).status().period.count, 2);
+    }
+}
+
+TEST(time_series_ut, wait_until)
+{
+    typedef std::chrono::steady_clock Clock;
+    TimeSeries<int> ts(10);
+    ASSERT_FALSE(ts.newest_until(Clock::now() + std::chrono::milliseconds(1)));
+    ts.append(0);
+    ASSERT_EQ(ts.newest_until(Clock::now())->element, 0);
+    ASSERT_EQ(ts.at_until(0, Clock::now())->index, 0);
+    ASSERT_TRUE(ts.wait_until(0, Clock::now()));
+
+    // appends of the elements preceding the awaited one (waking up the
+    // waiter) do not extend the wait
+    std::atomic<bool> running(true);
+    std::thread producer([&ts, &running]() {
+        while (running)
+        {
+            ts.append(0);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    Clock::time_point start = Clock::now();
+    ASSERT_FALSE(ts.at_until(1000000, start + std::chrono::milliseconds(50)));
+    ASSERT_FALSE(ts.wait_for_timeindex(1000000, 0.05));
+    double elapsed_s =
+        std::chrono::duration<double>(Clock::now() - start).count();
+    running = false;
+    producer.join();
+    ASSERT_GE(elapsed_s, 0.1);
+    ASSERT_LT(elapsed_s, 0.5);
+
+    std::thread delayed([&ts]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        ts.append(7);
+    });
+    Index next = ts.newest_timeindex() + 1;
+    std::optional<Sample<int>> sample =
+        ts.at_until(next, Clock::now() + std::chrono::seconds(5));
+    delayed.join();
+    ASSERT_TRUE(sample);
+    ASSERT_EQ(sample->element, 7);
+    ASSERT_THROW(ts.wait_until(0, Clock::now()), std::invalid_argument);
+
+    clear_memory(SEGMENT_ID);
+    typedef MultiprocessTimeSeries<int, SingleSegment> Mpt;
+    Mpt leader = Mpt::create_leader(SEGMENT_ID, 10);
+    Mpt follower = Mpt::create_follower(SEGMENT_ID);
+    start = Clock::now();
+    ASSERT_FALSE(follower.newest_until(start + std::chrono::milliseconds(20)));
+    ASSERT_GE(Clock::now() - start, std::chrono::milliseconds(20));
+    leader.append(3);
+    ASSERT_EQ(follower.at_until(0, Clock::now())->element, 3);
+}
+
+// element which assignment (while slow_assignment is set) busy waits
+// 50ms, keeping the time series locked
+static std::atomic<bool> slow_assignment(false);
+static std::atomic<bool> assigning(false);
+
+struct SlowAssignment
+{
+    SlowAssignment() = default;
+    SlowAssignment(const SlowAssignment&) = default;
+    SlowAssignment& operator=(const SlowAssignment&)
+    {
+        if (slow_assignment.exchange(false))
+        {
+            assigning = true;
+            auto end =
+                std::chrono::steady_clock::now() + std::chrono::milliseconds(50);
+            while (std::chrono::steady_clock::now() < end)
+            {
+            }
+        }
+        return *this;
+    }
+};
+
+// runs the calling thread with the SCHED_FIFO priority on the cpu
+static bool set_fifo_priority(int priority, int cpu)
+{
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    sched_param param;
+    param.sched_priority = priority;
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0 &&
+           pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+}
+
+TEST(time_series_ut, priority_inheritance)
+{
+    TimeSeries<SlowAssignment> ts(10,
+                                  0,
+                                  true,
+                                  PageBacking::DEFAULT_PAGES,
+                                  MemoryCommit::DEFAULT,
+                                  LockProtocol::PRIORITY_INHERITANCE);
+    std::atomic<double> latency_ms(-1);
+    {
+        // (restoring the scheduling of the thread, also when skipping)
+        SchedulingGuard guard;
+        int cpu = guard.first_cpu();
+        if (!set_fifo_priority(40, cpu))
+        {
+            GTEST_SKIP() << "SCHED_FIFO not permitted";
+        }
+
+        // priority inversion: the low priority thread holds the lock (slow
+        // assignment) when the high priority thread requests it, while a
+        // medium priority thread keeps the cpu busy for 300ms. All threads
+        // run on the same cpu.
+        slow_assignment = true;
+        assigning = false;
+        std::thread low([&ts, cpu]() {
+            set_fifo_priority(10, cpu);
+            ts.append(SlowAssignment());
+        });
+        while (!assigning)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::thread medium([cpu]() {
+            set_fifo_priority(20, cpu);
+            auto end = std::chrono::steady_clock::now() +
+                       std::chrono::milliseconds(300);
+            while (std::chrono::steady_clock::now() < end)
+            {
+            }
+        });
+        std::thread high([&ts, &latency_ms, cpu]() {
+            set_fifo_priority(30, cpu);
+            auto start = std::chrono::steady_clock::now();
+            ts.newest();
+            latency_ms = std::chrono::duration<double, std::milli>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+        });
+        high.join();
+        medium.join();
+        low.join();
+    }
+
+    // the low priority thread, inheriting the priority of the high priority
+    // one, completes its (at most 50ms) critical section without being
+    // preempted by the medium priority thread
+    ASSERT_GE(latency_ms.load(), 0.);
+    ASSERT_LT(latency_ms.load(), 150.);
+
+    clear_memory(SEGMENT_ID);
+    {
+        typedef MultiprocessTimeSeries<int, SingleSegment> Mpt;
+        Mpt leader = Mpt::create_leader(SEGMENT_ID,
+                                        10,
+                                        0,
+                                        PageBacking::DEFAULT_PAGES,
+                                        MemoryCommit::DEFAULT,
+                                        LockProtocol::PRIORITY_INHERITANCE);
+        Mpt follower = Mpt::create_follower(SEGMENT_ID);
+        leader.append(1);
+        ASSERT_EQ(follower[0], 1);
+    }
+    clear_memory(SEGMENT_ID);
+    typedef MultiprocessTimeSeries<int> Mpt;
+    ASSERT_THROW(Mpt::create_leader(SEGMENT_ID,
+                                    10,
+                                    0,
+                                    PageBacking::DEFAULT_PAGES,
+                                    MemoryCommit::DEFAULT,
+                                    LockProtocol::PRIORITY_INHERITANCE),
+                 std::invalid_argument);
+}
+
+// not trivially copyable, but with a fixed layout flat form
+struct Command
+{
+    std::vector<double> torques;
+};
+
+namespace time_series
+{
+template <>
+struct FlatForm<Command>
+{
+    typedef std::array<double, 3> type;
+    static void to_flat(const Command& command, type& flat)
+    {
+        std::size_t n = std::min(command.torques.size(), flat.size());
+        std::copy_n(command.torques.begin(), n, flat.begin());
+        std::fill(flat.begin() + n, flat.end(), 0.);
+    }
+    static void from_flat(const type& flat, Command& command)
+    {
+        command.torques.assign(flat.begin(), flat.end());
+    }
+};
+}  // namespace time_series
+
+TEST(time_series_ut, element_storage)
+{
+    static_assert(storage_method_v<double> == StorageMethod::RAW);
+    static_assert(storage_method_v<Type> == StorageMethod::RAW);
+    static_assert(storage_method_v<Command> == StorageMethod::FLAT);
+    static_assert(storage_method_v<std::string> == StorageMethod::SERIALIZED);
+    static_assert(MultiprocessTimeSeries<Type>::storage_method ==
+                  StorageMethod::SERIALIZED);
+    ASSERT_EQ(storage_report<Command>(), "flat (24 bytes)");
+    ASSERT_EQ(storage_report<double>(), "raw (8 bytes)");
+
+    clear_memory(SEGMENT_ID);
+    {
+        typedef MultiprocessTimeSeries<Command, SingleSegment> Mpt;
+        Mpt leader = Mpt::create_leader(SEGMENT_ID, 10);
+        Mpt follower = Mpt::create_follower(SEGMENT_ID);
+        leader.append(Command{{1., 2., 3.}});
+        ASSERT_EQ(follower[0].torques, (std::vector<double>{1., 2., 3.}));
+        double sum = 0;
+        follower.visit(0, [&sum](const std::array<double, 3>& flat) {
+            sum = flat[0] + flat[1] + flat[2];
+        });
+        ASSERT_DOUBLE_EQ(sum, 6.);
+        ASSERT_THROW(follower.get_raw(0), std::logic_error);
+    }
+    clear_memory(SEGMENT_ID);
+    {
+        typedef MultiprocessTimeSeries<Type, SingleSegment> Mpt;
+        Mpt leader = Mpt::create_leader(SEGMENT_ID, 10);
+        Mpt follower = Mpt::create_follower(SEGMENT_ID);
+        Type type;
+        leader.append(type);
+        ASSERT_EQ(follower[0], type);
+        bool equal = false;
+        follower.visit(
+            0, [&equal, &type](const Type& stored) { equal = stored == type; });
+        ASSERT_TRUE(equal);
+    }
+
+    // streamed as their flat form
+    std::string path = "/tmp/" SEGMENT_ID ".sock";
+    TimeSeries<Command> commands(10);
+    StreamPublisher<TimeSeries<Command>> publisher(
+        commands, StreamEndpoint::unix_socket(path));
+    TimeSeries<Command> local(10);
+    StreamSubscriber<Command> subscriber(local,
+                                         StreamEndpoint::unix_socket(path));
+    commands.append(Command{{1., 2., 3.}});
+    ASSERT_TRUE(eventually([&]() { return subscriber.received() == 1; }));
+    ASSERT_EQ(local[0].torques, (std::vector<double>{1., 2., 3.}));
+}
@@ -0,0 +1,102 @@
+/**
+ * @file test_coroutines.cpp
+ * license License BSD-3-Clause
+ * @copyright Copyright (c) 2019, Max Planck Gesellschaft.
+ *
+ * @brief Tests of the coroutine awaitables (coroutines.hpp), built as
+ * C++20 (the other tests and the library are built as C++17).
+ */
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "time_series/coroutines.hpp"
+#include "time_series/multiprocess_time_series.hpp"
+#include "time_series/reactor.hpp"
+#include "time_series/time_series.hpp"
+#include "time_series/worker_pool.hpp"
+
+#define SEGMENT_ID "coroutines_unittests"
+
+using namespace time_series;
+
+// minimal coroutine type, started eagerly and never awaited
+struct Detached
+{
+    struct promise_type
+    {
+        Detached get_return_object()
+        {
+            return {};
+        }
+        std::suspend_never initial_suspend()
+        {
+            return {};
+        }
+        std::suspend_never final_suspend() noexcept
+        {
+            return {};
+        }
+        void return_void()
+        {
+        }
+        void unhandled_exception()
+        {
+            std::terminate();
+        }
+    };
+};
+
+static Detached consume(TimeSeries<int>& ts, int nb, std::vector<int>& values)
+{
+    Index index = -1;
+    for (int i = 0; i < nb; i++)
+    {
+        // (resumed by append)
+        Sample<int> sample = co_await async_next(ts, index, InlineExecutor());
+        index = sample.index;
+        values.push_back(sample.element);
+    }
+}
+
+static Detached consume_follower(Reactor& reactor,
+                                 MultiprocessTimeSeries<int>& follower,
+                                 WorkerPool& pool,
+                                 std::atomic<int>& value)
+{
+    Sample<int> sample =
+        co_await async_at(reactor, follower, 0, pool.executor());
+    value = sample.element;
+}
+
+TEST(time_series_ut, coroutines)
+{
+    TimeSeries<int> ts(10);
+    std::vector<int> values;
+    consume(ts, 3, values);
+    ASSERT_TRUE(values.empty());
+    ts.append(10);
+    ts.append(11);
+    ts.append(12);
+    std::vector<int> expected{10, 11, 12};
+    ASSERT_EQ(values, expected);
+
+    clear_memory(SEGMENT_ID);
+    typedef MultiprocessTimeSeries<int> Mpt;
+    Mpt leader = Mpt::create_leader(SEGMENT_ID, 10);
+    Mpt follower = Mpt::create_follower(SEGMENT_ID);
+    Reactor reactor;
+    WorkerPool pool(1);
+    std::atomic<int> value(0);
+    consume_follower(reactor, follower, pool, value);
+    leader.append(7);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while (value.load() == 0 && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ(value.load(), 7);
+}
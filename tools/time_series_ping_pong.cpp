@@ -0,0 +1,589 @@
+/**
+ * @file time_series_ping_pong.cpp
+ * @copyright Copyright (c) 2019, Max Planck Gesellschaft.
+ *
+ * @brief Benchmark of the round trip latency between two processes
+ * communicating via multiprocess time series, e.g. for qualifying kernels
+ * and hardware.
+ *
+ * usage: time_series_ping_pong [-n round_trips] [-s sizes] [-w waits]
+ *                              [-c pinnings] [-f fifo_priority]
+ *
+ * The process forks: the parent appends an element to the "ping" time
+ * series, the child copies it into the "pong" time series, and the parent
+ * measures the time until it reads it back. This is repeated for each
+ * combination of:
+ * - element size (-s, bytes): 8, 64, 512, 4096 and 65536
+ * - wait (-w): blocking (condition variable), polling (PollingWait policy,
+ *   10us) or spin (busy polling of the newest index)
+ * - pinning (-c): none, same (both processes on the same cpu) or split
+ *   (the processes on two different cpus)
+ * (-s, -w and -c accept comma separated lists, all values by default).
+ * Spinning requires each process to run on its own cpu, so it is skipped
+ * for the combinations that do not guarantee it.
+ *
+ * With -f, both processes run with the SCHED_FIFO policy at this priority.
+ *
+ * Reported (microseconds): percentiles of the round trip latency, and the
+ * max jitter, i.e. the difference between the max and the median.
+ */
+
+#include <sched.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "time_series/multiprocess_time_series.hpp"
+
+typedef std::chrono::steady_clock Clock;
+
+#define PING_SEGMENT_ID "time_series_ping_pong_ping"
+#define PONG_SEGMENT_ID "time_series_ping_pong_pong"
+
+// only one element is in flight at any time
+static const std::size_t MAX_LENGTH = 16;
+
+// the parent gives up if a round trip takes longer than this,
+// the child if it gets no new element for this long
+static const std::chrono::seconds PARENT_TIMEOUT(1);
+static const std::chrono::seconds CHILD_TIMEOUT(10);
+
+static const std::size_t SIZES[] = {8, 64, 512, 4096, 65536};
+
+// trivially copyable, hence stored raw in the shared memory
+template <std::size_t Size>
+struct Payload
+{
+    std::array<char, Size> bytes;
+};
+
+enum class Wait
+{
+    BLOCKING,
+    POLLING,
+    SPIN
+};
+
+enum class Pinning
+{
+    NONE,
+    SAME,
+    SPLIT
+};
+
+std::string to_string(Wait wait)
+{
+    switch (wait)
+    {
+        case Wait::BLOCKING:
+            return "blocking";
+        case Wait::POLLING:
+            return "polling";
+        default:
+            return "spin";
+    }
+}
+
+std::string to_string(Pinning pinning)
+{
+    switch (pinning)
+    {
+        case Pinning::NONE:
+            return "none";
+        case Pinning::SAME:
+            return "same";
+        default:
+            return "split";
+    }
+}
+
+typedef time_series::TimeSeriesPolicies<time_series::MonotonicClock,
+                                        time_series::BlockingWait>
+    BlockingPolicies;
+
+// (also used when spinning: nobody waits on the condition variable,
+// so append does not have to check for waiters)
+typedef time_series::TimeSeriesPolicies<time_series::MonotonicClock,
+                                        time_series::PollingWait<10>>
+    PollingPolicies;
+
+struct Config
+{
+    std::size_t size;
+    Wait wait;
+    Pinning pinning;
+    long round_trips;
+    long warmup;
+};
+
+struct Result
+{
+    bool success = false;
+    std::string error;
+    // microseconds, sorted
+    std::vector<double> latencies;
+};
+
+// cpus the process may run on
+std::vector<int> allowed_cpus()
+{
+    cpu_set_t cpus;
+    std::vector<int> allowed;
+    if (sched_getaffinity(0, sizeof(cpus), &cpus) != 0)
+    {
+        return allowed;
+    }
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    {
+        if (CPU_ISSET(cpu, &cpus))
+        {
+            allowed.push_back(cpu);
+        }
+    }
+    return allowed;
+}
+
+bool pin(int cpu)
+{
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    return sched_setaffinity(0, sizeof(cpus), &cpus) == 0;
+}
+
+void unpin(const std::vector<int>& allowed)
+{
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (int cpu : allowed)
+    {
+        CPU_SET(cpu, &cpus);
+    }
+    sched_setaffinity(0, sizeof(cpus), &cpus);
+}
+
+// waits for the element of index of the time series, returns false
+// if it is not appended before the deadline
+template <typename TS>
+bool wait_for(const TS& ts,
+              time_series::Index index,
+              Wait wait,
+              const Clock::time_point& deadline)
+{
+    if (wait != Wait::SPIN)
+    {
+        return ts.wait_until(index, deadline);
+    }
+    long spins = 0;
+    while (ts.newest_timeindex(false) < index)
+    {
+        if ((++spins & 1023) == 0 && Clock::now() > deadline)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// child process: copies the elements of ping into pong
+template <std::size_t Size, typename Policies>
+void run_child(const Config& config, int cpu)
+{
+    typedef time_series::MultiprocessTimeSeries<Payload<Size>,
+                                                time_series::SingleSegment,
+                                                Policies>
+        TS;
+    if (cpu >= 0 && !pin(cpu))
+    {
+        _exit(2);
+    }
+    TS ping = TS::create_follower(PING_SEGMENT_ID,
+                                  time_series::MemoryCommit::LOCK);
+    TS pong = TS::create_follower(PONG_SEGMENT_ID,
+                                  time_series::MemoryCommit::LOCK);
+    Payload<Size> payload;
+    for (time_series::Index index = 0;
+         index < config.warmup + config.round_trips;
+         index++)
+    {
+        Clock::time_point deadline = Clock::now() + CHILD_TIMEOUT;
+        if (!wait_for(ping, index, config.wait, deadline))
+        {
+            _exit(3);
+        }
+        payload = ping[index];
+        pong.append(payload);
+    }
+    // (not destroying the followers, the leaders wipe the memory)
+    _exit(0);
+}
+
+// parent process: measures the round trips
+template <std::size_t Size, typename Policies>
+Result run_parent(const Config& config, const std::vector<int>& allowed)
+{
+    typedef time_series::MultiprocessTimeSeries<Payload<Size>,
+                                                time_series::SingleSegment,
+                                                Policies>
+        TS;
+    Result result;
+
+    int parent_cpu = -1;
+    int child_cpu = -1;
+    if (config.pinning != Pinning::NONE)
+    {
+        parent_cpu = allowed[0];
+        child_cpu = config.pinning == Pinning::SAME ? allowed[0] : allowed[1];
+    }
+
+    time_series::clear_memory(PING_SEGMENT_ID);
+    time_series::clear_memory(PONG_SEGMENT_ID);
+    TS ping = TS::create_leader(PING_SEGMENT_ID,
+                                MAX_LENGTH,
+                                0,
+                                time_series::PageBacking::DEFAULT_PAGES,
+                                time_series::MemoryCommit::LOCK);
+    TS pong = TS::create_leader(PONG_SEGMENT_ID,
+                                MAX_LENGTH,
+                                0,
+                                time_series::PageBacking::DEFAULT_PAGES,
+                                time_series::MemoryCommit::LOCK);
+
+    pid_t child = fork();
+    if (child < 0)
+    {
+        result.error = "fork failed";
+        return result;
+    }
+    if (child == 0)
+    {
+        run_child<Size, Policies>(config, child_cpu);
+    }
+
+    if (parent_cpu >= 0 && !pin(parent_cpu))
+    {
+        result.error = "failed to pin on cpu " + std::to_string(parent_cpu);
+    }
+
+    Payload<Size> payload{};
+    result.latencies.reserve(config.round_trips);
+    for (time_series::Index index = 0;
+         result.error.empty() && index < config.warmup + config.round_trips;
+         index++)
+    {
+        payload.bytes[0] = static_cast<char>(index);
+        Clock::time_point start = Clock::now();
+        ping.append(payload);
+        if (!wait_for(pong, index, config.wait, start + PARENT_TIMEOUT))
+        {
+            result.error = "no reply to round trip " + std::to_string(index);
+            break;
+        }
+        payload = pong[index];
+        Clock::time_point end = Clock::now();
+        if (index >= config.warmup)
+        {
+            result.latencies.push_back(
+                std::chrono::duration<double, std::micro>(end - start)
+                    .count());
+        }
+    }
+
+    if (!result.error.empty())
+    {
+        kill(child, SIGKILL);
+    }
+    int status;
+    waitpid(child, &status, 0);
+    if (result.error.empty() &&
+        (!WIFEXITED(status) || WEXITSTATUS(status) != 0))
+    {
+        result.error = "child process failed";
+    }
+    unpin(allowed);
+
+    result.success = result.error.empty();
+    std::sort(result.latencies.begin(), result.latencies.end());
+    return result;
+}
+
+template <std::size_t Size>
+Result run(const Config& config, const std::vector<int>& allowed)
+{
+    if (config.wait == Wait::BLOCKING)
+    {
+        return run_parent<Size, BlockingPolicies>(config, allowed);
+    }
+    return run_parent<Size, PollingPolicies>(config, allowed);
+}
+
+Result run(const Config& config, const std::vector<int>& allowed)
+{
+    switch (config.size)
+    {
+        case 8:
+            return run<8>(config, allowed);
+        case 64:
+            return run<64>(config, allowed);
+        case 512:
+            return run<512>(config, allowed);
+        case 4096:
+            return run<4096>(config, allowed);
+        default:
+            return run<65536>(config, allowed);
+    }
+}
+
+// reason for not running the configuration, empty if it can run
+std::string skip(const Config& config, const std::vector<int>& allowed)
+{
+    if (config.pinning == Pinning::SPLIT && allowed.size() < 2)
+    {
+        return "requires 2 cpus";
+    }
+    if (config.wait == Wait::SPIN &&
+        (config.pinning == Pinning::SAME ||
+         (config.pinning == Pinning::NONE && allowed.size() < 2)))
+    {
+        return "spinning requires a cpu per process";
+    }
+    return "";
+}
+
+// (sorted latencies)
+double percentile(const std::vector<double>& latencies, double p)
+{
+    std::size_t rank = static_cast<std::size_t>(
+        std::ceil(p / 100. * static_cast<double>(latencies.size())));
+    return latencies[std::max<std::size_t>(rank, 1) - 1];
+}
+
+void print_header()
+{
+    std::printf("%8s %9s %8s %9s %9s %9s %9s %9s %9s %9s %9s\n",
+                "SIZE(B)",
+                "WAIT",
+                "PINNING",
+                "MIN(us)",
+                "P50",
+                "P90",
+                "P99",
+                "P99.9",
+                "P99.99",
+                "MAX",
+                "JITTER");
+    std::fflush(stdout);
+}
+
+void print(const Config& config, const Result& result, const std::string& skip)
+{
+    std::printf("%8zu %9s %8s ",
+                config.size,
+                to_string(config.wait).c_str(),
+                to_string(config.pinning).c_str());
+    if (!skip.empty())
+    {
+        std::printf("skipped (%s)\n", skip.c_str());
+    }
+    else if (!result.success)
+    {
+        std::printf("failed (%s)\n", result.error.c_str());
+    }
+    else
+    {
+        const std::vector<double>& l = result.latencies;
+        double median = percentile(l, 50);
+        std::printf("%9.2f %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f %9.2f\n",
+                    l.front(),
+                    median,
+                    percentile(l, 90),
+                    percentile(l, 99),
+                    percentile(l, 99.9),
+                    percentile(l, 99.99),
+                    l.back(),
+                    l.back() - median);
+    }
+    std::fflush(stdout);
+}
+
+std::vector<std::string> split(const std::string& list)
+{
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+        items.push_back(item);
+    }
+    return items;
+}
+
+int usage(const char* program)
+{
+    std::fprintf(stderr,
+                 "usage: %s [-n round_trips] [-s sizes] [-w waits] "
+                 "[-c pinnings] [-f fifo_priority]\n"
+                 "  sizes: comma separated, among 8,64,512,4096,65536\n"
+                 "  waits: comma separated, among blocking,polling,spin\n"
+                 "  pinnings: comma separated, among none,same,split\n",
+                 program);
+    return 1;
+}
+
+int main(int argc, char* argv[])
+{
+    long round_trips = 1000000;
+    int fifo_priority = 0;
+    std::vector<std::size_t> sizes(std::begin(SIZES), std::end(SIZES));
+    std::vector<Wait> waits = {Wait::BLOCKING, Wait::POLLING, Wait::SPIN};
+    std::vector<Pinning> pinnings = {
+        Pinning::NONE, Pinning::SAME, Pinning::SPLIT};
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg(argv[i]);
+        if (i + 1 >= argc)
+        {
+            return usage(argv[0]);
+        }
+        std::string value(argv[++i]);
+        if (arg == "-n" || arg == "-f")
+        {
+            long number = std::atol(value.c_str());
+            if (number <= 0)
+            {
+                std::fprintf(stderr, "%s should be positive\n", arg.c_str());
+                return 1;
+            }
+            if (arg == "-n")
+            {
+                round_trips = number;
+            }
+            else
+            {
+                fifo_priority = static_cast<int>(number);
+            }
+        }
+        else if (arg == "-s")
+        {
+            sizes.clear();
+            for (const std::string& item : split(value))
+            {
+                std::size_t size = std::atol(item.c_str());
+                if (std::find(std::begin(SIZES), std::end(SIZES), size) ==
+                    std::end(SIZES))
+                {
+                    return usage(argv[0]);
+                }
+                sizes.push_back(size);
+            }
+        }
+        else if (arg == "-w")
+        {
+            waits.clear();
+            for (const std::string& item : split(value))
+            {
+                if (item == "blocking")
+                {
+                    waits.push_back(Wait::BLOCKING);
+                }
+                else if (item == "polling")
+                {
+                    waits.push_back(Wait::POLLING);
+                }
+                else if (item == "spin")
+                {
+                    waits.push_back(Wait::SPIN);
+                }
+                else
+                {
+                    return usage(argv[0]);
+                }
+            }
+        }
+        else if (arg == "-c")
+        {
+            pinnings.clear();
+            for (const std::string& item : split(value))
+            {
+                if (item == "none")
+                {
+                    pinnings.push_back(Pinning::NONE);
+                }
+                else if (item == "same")
+                {
+                    pinnings.push_back(Pinning::SAME);
+                }
+                else if (item == "split")
+                {
+                    pinnings.push_back(Pinning::SPLIT);
+                }
+                else
+                {
+                    return usage(argv[0]);
+                }
+            }
+        }
+        else
+        {
+            return usage(argv[0]);
+        }
+    }
+
+    if (fifo_priority > 0)
+    {
+        // (inherited by the child processes)
+        sched_param param;
+        param.sched_priority = fifo_priority;
+        if (sched_setscheduler(0, SCHED_FIFO, &param) != 0)
+        {
+            std::fprintf(stderr,
+                         "failed to set the SCHED_FIFO priority %d\n",
+                         fifo_priority);
+            return 1;
+        }
+    }
+
+    std::vector<int> allowed = allowed_cpus();
+    std::printf("%ld round trips per run, %zu cpu(s), %s scheduling\n",
+                round_trips,
+                allowed.size(),
+                fifo_priority > 0
+                    ? ("SCHED_FIFO " + std::to_string(fifo_priority)).c_str()
+                    : "default");
+    print_header();
+
+    for (std::size_t size : sizes)
+    {
+        for (Wait wait : waits)
+        {
+            for (Pinning pinning : pinnings)
+            {
+                Config config;
+                config.size = size;
+                config.wait = wait;
+                config.pinning = pinning;
+                config.round_trips = round_trips;
+                config.warmup = std::min<long>(round_trips, 10000);
+                std::string reason = skip(config, allowed);
+                Result result;
+                if (reason.empty())
+                {
+                    result = run(config, allowed);
+                }
+                print(config, result, reason);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,280 @@
+/**
+ * @file time_series_top.cpp
+ * @copyright Copyright (c) 2019, Max Planck Gesellschaft.
+ *
+ * @brief Live monitor of the multiprocess time series in shared memory:
+ * append rate, jitter of the interval between appends, length,
+ * age of the newest element and lag of the tag, refreshed periodically.
+ *
+ * usage: time_series_top [-p refresh_period_s] [-s sampling_period_ms]
+ *                        [-n nb_refreshes] [segment_id ...]
+ *
+ * If no segment id is given, all the time series found in shared memory
+ * are monitored (see SegmentMonitor::discover).
+ *
+ * Only the indexes of the time series are read (without locking), so that
+ * monitoring does not contend with the writers and readers. The time of
+ * the appends is therefore observed by polling the indexes every sampling
+ * period, which bounds the resolution of the jitter and age. For the time
+ * series with the TrackPeriod policy, the jitter is instead the one
+ * tracked by the writers (from the timestamps of the elements), marked
+ * with '*'.
+ */
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "time_series/segment_monitor.hpp"
+
+typedef std::chrono::steady_clock Clock;
+
+/**
+ * @brief appends of a time series observed during a refresh period
+ */
+struct Observation
+{
+    Observation(const std::string& segment_id)
+        : monitor(segment_id),
+          last(monitor.status()),
+          last_change(Clock::now()),
+          changed(false),
+          appended(0),
+          nb_intervals(0),
+          mean_interval(0),
+          m2_interval(0)
+    {
+    }
+
+    void sample(const Clock::time_point& now)
+    {
+        time_series::SegmentStatus status = monitor.status();
+        if (status.newest > last.newest)
+        {
+            time_series::Index nb = status.newest - last.newest;
+            if (changed)
+            {
+                // the appends observed since the previous change are
+                // considered evenly spread
+                double interval = std::chrono::duration<double, std::milli>(
+                                      now - last_change)
+                                      .count() /
+                                  nb;
+                for (time_series::Index i = 0; i < nb; i++)
+                {
+                    // (Welford)
+                    nb_intervals++;
+                    double delta = interval - mean_interval;
+                    mean_interval += delta / nb_intervals;
+                    m2_interval += delta * (interval - mean_interval);
+                }
+            }
+            appended += nb;
+            last_change = now;
+            changed = true;
+        }
+        last = status;
+    }
+
+    void reset()
+    {
+        appended = 0;
+        nb_intervals = 0;
+        mean_interval = 0;
+        m2_interval = 0;
+    }
+
+    time_series::SegmentMonitor monitor;
+    time_series::SegmentStatus last;
+    Clock::time_point last_change;
+    // false until an append is observed (last_change being then the
+    // start of the monitoring)
+    bool changed;
+    time_series::Index appended;
+    long nb_intervals;
+    double mean_interval;
+    double m2_interval;
+};
+
+void print(const std::map<std::string, Observation>& observations,
+           double period_s,
+           const Clock::time_point& now)
+{
+    if (isatty(STDOUT_FILENO))
+    {
+        // clearing the terminal
+        std::printf("\033[2J\033[H");
+    }
+    std::printf("%-32s %8s %10s %10s %17s %10s %8s %7s\n",
+                "SEGMENT",
+                "LEADER",
+                "RATE(Hz)",
+                "JITTER(ms)",
+                "LENGTH/MAX",
+                "AGE(ms)",
+                "TAG LAG",
+                "WAITING");
+    for (const auto& entry : observations)
+    {
+        const Observation& o = entry.second;
+        const time_series::SegmentStatus& s = o.last;
+        std::string leader =
+            s.leader_pid == 0 ? "-"
+                              : std::to_string(s.leader_pid) +
+                                    (s.leader_alive ? "" : "!");
+        // (standard deviation of the interval between appends)
+        char jitter[16] = "-";
+        if (s.period.count > 1)
+        {
+            std::snprintf(
+                jitter, sizeof(jitter), "%.3f*", s.period.stddev_ms());
+        }
+        else if (o.nb_intervals > 1)
+        {
+            std::snprintf(jitter,
+                          sizeof(jitter),
+                          "%.3f",
+                          std::sqrt(o.m2_interval / (o.nb_intervals - 1)));
+        }
+        std::string length = std::to_string(s.length()) + "/" +
+                             std::to_string(s.max_length);
+        std::string age =
+            s.newest < s.start || !o.changed
+                ? "-"
+                : std::to_string(static_cast<long>(
+                      std::chrono::duration<double, std::milli>(now -
+                                                                o.last_change)
+                          .count()));
+        std::string tag_lag =
+            s.tagged < s.start ? "-" : std::to_string(s.newest - s.tagged);
+        std::string waiting =
+            s.waiters < 0 ? "-" : std::to_string(s.waiters);
+        std::printf("%-32s %8s %10.1f %10s %17s %10s %8s %7s\n",
+                    entry.first.c_str(),
+                    leader.c_str(),
+                    o.appended / period_s,
+                    jitter,
+                    length.c_str(),
+                    age.c_str(),
+                    tag_lag.c_str(),
+                    waiting.c_str());
+    }
+    std::printf(
+        "(leader: '!' if the process is dead, jitter: '*' if tracked by "
+        "the writers, age: since the newest append observed by this "
+        "monitor)\n");
+    std::fflush(stdout);
+}
+
+// starts monitoring the time series not monitored yet,
+// and stops monitoring the time series which disappeared
+void update(const std::vector<std::string>& segment_ids,
+            std::map<std::string, Observation>& observations)
+{
+    std::map<std::string, Observation> updated;
+    for (const std::string& segment_id : segment_ids)
+    {
+        auto it = observations.find(segment_id);
+        if (it != observations.end())
+        {
+            updated.emplace(segment_id, std::move(it->second));
+            continue;
+        }
+        try
+        {
+            updated.emplace(segment_id, Observation(segment_id));
+        }
+        catch (const std::runtime_error&)
+        {
+            // leader not started yet, or leftover of a leader
+            // of an older version
+        }
+    }
+    observations.swap(updated);
+}
+
+int main(int argc, char* argv[])
+{
+    double refresh_period_s = 1.0;
+    double sampling_period_ms = 1.0;
+    long nb_refreshes = -1;
+    std::vector<std::string> segment_ids;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg(argv[i]);
+        if ((arg == "-p" || arg == "-s" || arg == "-n") && i + 1 < argc)
+        {
+            double value = std::atof(argv[++i]);
+            if (!(value > 0))
+            {
+                std::fprintf(stderr, "%s should be positive\n", arg.c_str());
+                return 1;
+            }
+            if (arg == "-p")
+            {
+                refresh_period_s = value;
+            }
+            else if (arg == "-s")
+            {
+                sampling_period_ms = value;
+            }
+            else
+            {
+                nb_refreshes = static_cast<long>(value);
+            }
+        }
+        else if (!arg.empty() && arg[0] == '-')
+        {
+            std::fprintf(stderr,
+                         "usage: %s [-p refresh_period_s] "
+                         "[-s sampling_period_ms] [-n nb_refreshes] "
+                         "[segment_id ...]\n",
+                         argv[0]);
+            return 1;
+        }
+        else
+        {
+            segment_ids.push_back(arg);
+        }
+    }
+    bool discover = segment_ids.empty();
+
+    std::map<std::string, Observation> observations;
+    std::chrono::duration<double> refresh_period(refresh_period_s);
+    std::chrono::duration<double, std::milli> sampling_period(
+        sampling_period_ms);
+    for (long refresh = 0; nb_refreshes < 0 || refresh < nb_refreshes;
+         refresh++)
+    {
+        update(discover ? time_series::SegmentMonitor::discover()
+                        : segment_ids,
+               observations);
+        Clock::time_point start = Clock::now();
+        for (auto& entry : observations)
+        {
+            entry.second.reset();
+        }
+        Clock::time_point now = start;
+        while (now - start < refresh_period)
+        {
+            std::this_thread::sleep_for(sampling_period);
+            now = Clock::now();
+            for (auto& entry : observations)
+            {
+                entry.second.sample(now);
+            }
+        }
+        print(observations,
+              std::chrono::duration<double>(now - start).count(),
+              now);
+    }
+    return 0;
+}